@@ -27,6 +27,7 @@
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/impacted.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -78,7 +79,7 @@ namespace graphene { namespace app {
     {
        if( api_name == "database_api" )
        {
-          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ) );
+          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ), _app.chain_notifications() );
        }
        else if( api_name == "network_broadcast_api" )
        {
@@ -441,11 +442,9 @@ namespace graphene { namespace app {
                                                                        unsigned limit,
                                                                        operation_history_id_type start ) const
     {
-       return get_account_history_impl(account,
-                                       [](const account_transaction_history_object*) { return true; },
-                                       stop,
-                                       limit,
-                                       start);
+       const uint32_t start_seq = start == operation_history_id_type() ? std::numeric_limits<uint32_t>::max()
+                                                                       : get_account_sequence( account, start );
+       return get_account_history_by_sequence( account, nullptr, get_account_sequence( account, stop ), limit, start_seq );
     }
 
     vector<operation_history_object> history_api::get_account_history_by_operation(account_id_type account,
@@ -454,14 +453,10 @@ namespace graphene { namespace app {
                                                                       unsigned limit,
                                                                       operation_history_id_type start) const
     {
-       FC_ASSERT( _app.chain_database() );
-       const auto& db = *_app.chain_database();
-       return get_account_history_impl(account,
-                                       [&operation_types, &db](const account_transaction_history_object* node) {
-                                           return operation_types.find(node->operation_id(db).op.which()) != operation_types.end(); },
-                                       stop,
-                                       limit,
-                                       start);
+       const uint32_t start_seq = start == operation_history_id_type() ? std::numeric_limits<uint32_t>::max()
+                                                                       : get_account_sequence( account, start );
+       return get_account_history_by_sequence( account, &operation_types, get_account_sequence( account, stop ), limit,
+                                               start_seq );
     }
 
     vector<operation_history_object> history_api::get_relative_account_history( account_id_type account,
@@ -471,25 +466,21 @@ namespace graphene { namespace app {
     {
        FC_ASSERT( _app.chain_database() );
        const auto& db = *_app.chain_database();
-       FC_ASSERT(limit <= 100);
-       vector<operation_history_object> result;
-       if( start == 0 )
-         start = account(db).statistics(db).total_ops;
-       else start = min( account(db).statistics(db).total_ops, start );
-       const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-       const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
-
-       auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
-       auto itr_stop = by_seq_idx.lower_bound( boost::make_tuple( account, stop ) );
-       --itr;
-
-       while ( itr != itr_stop && result.size() < limit )
-       {
-          result.push_back( itr->operation_id(db) );
-          --itr;
-       }
+       const uint32_t total_ops = account(db).statistics(db).total_ops;
+       // The entry at stop is left out, and sequence numbers start at 1: a stop of 0 leaves out the first entry of
+       // the account, as this call always did.
+       return get_account_history_by_sequence( account, nullptr, std::max( stop, 1u ), limit,
+                                               start == 0 ? total_ops : std::min( total_ops, start ) );
+    }
 
-       return result;
+    vector<operation_history_object> history_api::get_relative_account_history_by_operation( account_id_type account,
+                                                                                             flat_set<uint32_t> operation_types,
+                                                                                             uint32_t stop,
+                                                                                             unsigned limit,
+                                                                                             uint32_t start) const
+    {
+       return get_account_history_by_sequence( account, &operation_types, stop, limit,
+                                               start == 0 ? std::numeric_limits<uint32_t>::max() : start );
     }
 
     flat_set<uint32_t> history_api::get_market_history_buckets()const
@@ -525,32 +516,110 @@ namespace graphene { namespace app {
        return result;
     } FC_CAPTURE_AND_RETHROW( (a)(b)(bucket_seconds)(start)(end) ) }
 
-    vector<operation_history_object> history_api::get_account_history_impl( account_id_type account,
-                                                                            const std::function<bool(const account_transaction_history_object* node)> &selector,
-                                                                            operation_history_id_type stop,
-                                                                            unsigned limit,
-                                                                            operation_history_id_type start ) const
-    {
-        FC_ASSERT( _app.chain_database() );
-        const auto& db = *_app.chain_database();
-        FC_ASSERT( limit <= 100 );
-        vector<operation_history_object> result;
-        const auto& stats = account(db).statistics(db);
-        if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-        const account_transaction_history_object* node = &stats.most_recent_op(db);
-        if( start == operation_history_id_type() )
-            start = node->operation_id;
-
-        while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
-        {
-            if( node->operation_id.instance.value <= start.instance.value && selector(node) )
-                result.push_back( node->operation_id(db) );
-            if( node->next == account_transaction_history_id_type() )
-                node = nullptr;
-            else node = &node->next(db);
-        }
-
-        return result;
+    static const graphene::account_history::cold_history_store* get_cold_history_store( const application& app )
+    {
+       auto plugin = std::dynamic_pointer_cast<graphene::account_history::account_history_plugin>(
+                        app.get_plugin( "account_history" ) );
+       return plugin ? plugin->cold_store() : nullptr;
+    }
+
+    static void get_account_history_by_operation_types( const graphene::chain::database& db, account_id_type account,
+                                                        const flat_set<uint32_t>& operation_types,
+                                                        uint32_t stop, unsigned limit, uint32_t start,
+                                                        vector<operation_history_object>& result )
+    {
+       // Every type has its own range in by_op_type, ordered by sequence. Merge them, newest first:
+       const auto& by_type_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_op_type>();
+       using range_type = std::pair<decltype(by_type_idx.begin()), decltype(by_type_idx.begin())>;
+       vector<range_type> ranges;
+       ranges.reserve( operation_types.size() );
+       for( auto type : operation_types )
+       {
+          auto first = by_type_idx.upper_bound( boost::make_tuple( account, type, stop ) );
+          auto last = by_type_idx.upper_bound( boost::make_tuple( account, type, start ) );
+          if( first != last )
+             ranges.emplace_back( first, last );
+       }
+
+       while( result.size() < limit )
+       {
+          range_type* newest = nullptr;
+          for( auto& range : ranges )
+          {
+             if( range.first != range.second
+                 && ( newest == nullptr || std::prev( range.second )->sequence > std::prev( newest->second )->sequence ) )
+                newest = &range;
+          }
+          if( newest == nullptr )
+             break;
+
+          --newest->second;
+          result.push_back( newest->second->operation_id(db) );
+       }
+    }
+
+    uint32_t history_api::get_account_sequence( account_id_type account, operation_history_id_type op_id )const
+    {
+       FC_ASSERT( _app.chain_database() );
+       const auto& db = *_app.chain_database();
+       const auto& by_op_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_op>();
+
+       // Sequence numbers grow with operation ids within an account:
+       auto itr = by_op_idx.upper_bound( boost::make_tuple( account, op_id ) );
+       if( itr != by_op_idx.begin() && std::prev( itr )->account == account )
+          return std::prev( itr )->sequence;
+
+       // The operation is older than the history kept in memory:
+       const auto* cold = get_cold_history_store( _app );
+       return cold != nullptr ? cold->find_sequence( account, op_id ) : 0;
+    }
+
+    vector<operation_history_object> history_api::get_account_history_by_sequence( account_id_type account,
+                                                                                   const flat_set<uint32_t>* operation_types,
+                                                                                   uint32_t stop,
+                                                                                   unsigned limit,
+                                                                                   uint32_t start )const
+    {
+       FC_ASSERT( _app.chain_database() );
+       const auto& db = *_app.chain_database();
+       FC_ASSERT( limit <= 100 );
+       vector<operation_history_object> result;
+       if( start <= stop )
+          return result;
+
+       const auto& hist_idx = db.get_index_type<account_transaction_history_index>().indices();
+       const auto& by_seq_idx = hist_idx.get<by_seq>();
+       if( operation_types == nullptr )
+       {
+          auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
+          const auto itr_stop = by_seq_idx.upper_bound( boost::make_tuple( account, stop ) );
+          while( itr != itr_stop && result.size() < limit )
+          {
+             --itr;
+             result.push_back( itr->operation_id(db) );
+          }
+       }
+       else
+          get_account_history_by_operation_types( db, account, *operation_types, stop, limit, start, result );
+
+       // Continue below the oldest entry in memory with the entries moved to the cold store:
+       const auto* cold = get_cold_history_store( _app );
+       if( cold != nullptr && result.size() < limit )
+       {
+          auto oldest = by_seq_idx.lower_bound( boost::make_tuple( account ) );
+          if( oldest != by_seq_idx.end() && oldest->account == account )
+             start = std::min( start, oldest->sequence - 1 );
+
+          cold->for_each( account, start, [&]( const graphene::account_history::cold_history_store::record& r ) {
+             if( r.sequence <= stop )
+                return false;
+             if( operation_types == nullptr || operation_types->count( r.op_type ) )
+                result.push_back( cold->load( r ) );
+             return result.size() < limit;
+          } );
+       }
+
+       return result;
     }
 
     crypto_api::crypto_api(){};
@@ -24,6 +24,7 @@
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
+#include <graphene/app/notification_hub.hpp>
 #include <graphene/app/plugin.hpp>
 
 #include <graphene/chain/protocol/fee_schedule.hpp>
@@ -252,7 +253,8 @@ namespace detail {
          _websocket_server->on_connection([&]( const fc::http::websocket_connection_ptr& c ){
             auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c);
             auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
-            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()) );
+            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()),
+                                                                         _self->chain_notifications() );
             wsc->register_api(fc::api<graphene::app::database_api>(db_api));
             wsc->register_api(fc::api<graphene::app::login_api>(login));
             c->set_session_data( wsc );
@@ -280,7 +282,8 @@ namespace detail {
          _websocket_tls_server->on_connection([&]( const fc::http::websocket_connection_ptr& c ){
             auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c);
             auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
-            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()) );
+            auto db_api = std::make_shared<graphene::app::database_api>( std::ref(*_self->chain_database()),
+                                                                         _self->chain_notifications() );
             wsc->register_api(fc::api<graphene::app::database_api>(db_api));
             wsc->register_api(fc::api<graphene::app::login_api>(login));
             c->set_session_data( wsc );
@@ -292,7 +295,8 @@ namespace detail {
 
       application_impl(application* self)
          : _self(self),
-           _chain_db(std::make_shared<chain::database>())
+           _chain_db(std::make_shared<chain::database>()),
+           _notification_hub(std::make_shared<notification_hub>(*_chain_db))
       {
       }
 
@@ -377,6 +381,10 @@ namespace detail {
          if( _options->count("replay-blockchain") )
             _chain_db->wipe( _data_dir / "blockchain", false );
 
+         if( _options->count("load-snapshot") )
+            _chain_db->load_snapshot( _options->at("load-snapshot").as<boost::filesystem::path>(),
+                                      _data_dir / "blockchain", GRAPHENE_CURRENT_DB_VERSION );
+
          try
          {
             _chain_db->open( _data_dir / "blockchain", initial_state, GRAPHENE_CURRENT_DB_VERSION );
@@ -387,6 +395,17 @@ namespace detail {
             throw;
          }
 
+         if( _options->count("snapshot-interval") )
+         {
+            fc::path snapshot_dir = _data_dir / "snapshots";
+            if( _options->count("snapshot-dir") )
+               snapshot_dir = _options->at("snapshot-dir").as<boost::filesystem::path>();
+            _chain_db->set_snapshot_interval( snapshot_dir, _options->at("snapshot-interval").as<uint32_t>() );
+         }
+
+         if( _options->count("flush-interval") )
+            _chain_db->set_flush_interval( _options->at("flush-interval").as<uint32_t>() );
+
          if( _options->count("force-validate") )
          {
             ilog( "All transaction signatures will be validated" );
@@ -878,6 +897,7 @@ namespace detail {
       api_access _apiaccess;
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
+      std::shared_ptr<notification_hub>                     _notification_hub;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
@@ -923,6 +943,9 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
          ("dbg-init-key", bpo::value<string>(), "Block signing key to use for init witnesses, overrides genesis file")
          ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
+         ("snapshot-interval", bpo::value<uint32_t>(), "Write a snapshot of the irreversible chain state every this many blocks")
+         ("snapshot-dir", bpo::value<boost::filesystem::path>(), "Directory to write state snapshots to, defaults to <data-dir>/snapshots")
+         ("flush-interval", bpo::value<uint32_t>(), "Flush the changed parts of the irreversible chain state to disk every this many blocks")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -932,6 +955,7 @@ void application::set_program_options(boost::program_options::options_descriptio
           "invalid file is found, it will be replaced with an example Genesis State.")
          ("replay-blockchain", "Rebuild object graph by replaying all blocks")
          ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
+         ("load-snapshot", bpo::value<boost::filesystem::path>(), "Start from a state snapshot directory and replay only the blocks after it")
          ("force-validate", "Force validation of all transactions")
          ("genesis-timestamp", bpo::value<uint32_t>(), "Replace timestamp from genesis.json with current time plus this many seconds (experts only!)")
          ;
@@ -998,6 +1022,16 @@ std::shared_ptr<chain::database> application::chain_database() const
    return my->_chain_db;
 }
 
+std::shared_ptr<notification_hub> application::chain_notifications() const
+{
+   return my->_notification_hub;
+}
+
+const fc::path& application::data_dir() const
+{
+   return my->_data_dir;
+}
+
 void application::set_block_production(bool producing_blocks)
 {
    my->_is_block_producer = producing_blocks;
@@ -29,7 +29,6 @@
 
 #include <graphene/chain/issued_asset_record_object.hpp>
 
-#include <fc/bloom_filter.hpp>
 #include <fc/smart_ref_impl.hpp>
 
 #include <fc/crypto/hex.hpp>
@@ -40,6 +39,7 @@
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include <cctype>
+#include <deque>
 #include <cmath>
 
 #include <cfenv>
@@ -54,10 +54,10 @@ typedef std::map< std::pair<graphene::chain::asset_id_type, graphene::chain::ass
 class database_api_impl;
 
 
-class database_api_impl : public std::enable_shared_from_this<database_api_impl>
+class database_api_impl : public std::enable_shared_from_this<database_api_impl>, public notification_session
 {
    public:
-      database_api_impl( graphene::chain::database& db );
+      database_api_impl( graphene::chain::database& db, std::shared_ptr<notification_hub> hub );
       ~database_api_impl();
 
       // Objects
@@ -68,6 +68,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void set_pending_transaction_callback( std::function<void(const variant&)> cb );
       void set_block_applied_callback( std::function<void(const variant& block_id)> cb );
       void cancel_all_subscriptions();
+      notification_hub_statistics get_subscription_statistics()const;
 
       // Blocks and transactions
       optional<block_header> get_block_header(uint32_t block_num)const;
@@ -200,42 +201,28 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       // Das33
       vector<das33_pledge_holder_object> get_das33_pledges(das33_pledge_holder_id_type from, uint32_t limit) const;
       vector<das33_pledge_holder_object> get_das33_pledges_by_account(account_id_type account) const;
+      vector<das33_pledge_holder_object> get_das33_pledges_by_account_paged(account_id_type account, das33_pledge_holder_id_type from, uint32_t limit) const;
       vector<das33_pledge_holder_object> get_das33_pledges_by_project(das33_project_id_type project, das33_pledge_holder_id_type from, uint32_t limit) const;
       vector<das33_project_object> get_das33_projects(const string& lower_bound_name, uint32_t limit) const;
 
 
-      template<typename T>
-      void subscribe_to_item( const T& i )const
+      void subscribe_to_item( object_id_type id )const
       {
-         auto vec = fc::raw::pack(i);
          if( !_subscribe_callback )
             return;
 
-         if( !is_subscribed_to_item(i) )
-         {
-            idump((i));
-            _subscribe_filter.insert( vec.data(), vec.size() );//(vecconst char*)&i, sizeof(i) );
-         }
+         _notification_hub->subscribe_to_item( this, id );
       }
 
-      template<typename T>
-      bool is_subscribed_to_item( const T& i )const
+      template<uint8_t SpaceID, uint8_t TypeID, typename T>
+      void subscribe_to_item( const object_id<SpaceID, TypeID, T>& id )const
       {
-         if( !_subscribe_callback )
-            return false;
-
-         return _subscribe_filter.contains( i );
+         subscribe_to_item( object_id_type(id) );
       }
 
-      bool is_impacted_account( const flat_set<account_id_type>& accounts)
-      {
-         if( !_subscribed_accounts.size() || !accounts.size() )
-            return false;
-         
-         return std::any_of(accounts.begin(), accounts.end(), [this](const account_id_type& account) {
-            return _subscribed_accounts.find(account) != _subscribed_accounts.end();
-         });
-      }
+      /// Only objects are ever notified, subscribing to keys and addresses has no effect.
+      template<typename T>
+      void subscribe_to_item( const T& )const {}
 
       // TODO: figure out some way to use copy.
       template<typename IndexType, typename IndexBy>
@@ -342,39 +329,39 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       }
 
       template<typename T>
-      void enqueue_if_subscribed_to_market(const object* obj, market_queue_type& queue, bool full_object=true)
+      void enqueue_if_subscribed_to_market(const object_notification_batch& batch, size_t i, market_queue_type& queue, bool full_object=true)
       {
-         const T* order = dynamic_cast<const T*>(obj);
-         FC_ASSERT( order != nullptr);
+         const T* order = dynamic_cast<const T*>(batch.get_object(i));
+         if( order == nullptr )
+            return;
 
          auto market = order->get_market();
 
          auto sub = _market_subscriptions.find( market );
          if( sub != _market_subscriptions.end() ) {
-            queue[market].emplace_back( full_object ? obj->to_variant() : fc::variant(obj->id) );
+            queue[market].emplace_back( full_object ? batch.get_payload(i) : fc::variant(order->id) );
          }
       }
 
-      void broadcast_updates( const vector<variant>& updates );
+      void broadcast_updates( vector<variant>&& updates );
       void broadcast_market_updates( const market_queue_type& queue);
-      void handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object);
+      void flush_updates();
 
-      /** called every time a block is applied to report the objects that were changed */
-      void on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
-      void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts);
+      /** called by the notification hub every time a block is applied to report the objects that were changed */
+      void on_objects_notification( const object_notification_batch& batch, bool account_impacted,
+                                    const vector<size_t>& subscribed_items ) override;
       void on_applied_block();
 
       bool _notify_remove_create = false;
-      mutable fc::bloom_filter _subscribe_filter;
-      std::set<account_id_type> _subscribed_accounts;
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
 
-      boost::signals2::scoped_connection _new_connection;
-      boost::signals2::scoped_connection _change_connection;
-      boost::signals2::scoped_connection _removed_connection;
+      /// updates selected on the chain thread, waiting to be sent to the client
+      std::deque<fc::variant> _pending_updates;
+      bool _flush_scheduled = false;
+
+      std::shared_ptr<notification_hub> _notification_hub;
       boost::signals2::scoped_connection _applied_block_connection;
       boost::signals2::scoped_connection _pending_trx_connection;
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> > _market_subscriptions;
@@ -392,24 +379,21 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-database_api::database_api( graphene::chain::database& db )
-   : my( new database_api_impl( db ) ) {}
+database_api::database_api( graphene::chain::database& db, std::shared_ptr<notification_hub> hub )
+   : my( new database_api_impl( db, std::move(hub) ) ) {}
 
 database_api::~database_api() {}
 
-database_api_impl::database_api_impl( graphene::chain::database& db ): _db(db), _dal(db)
+database_api_impl::database_api_impl( graphene::chain::database& db, std::shared_ptr<notification_hub> hub )
+   : _notification_hub(std::move(hub)), _db(db), _dal(db)
 {
    wlog("creating database api ${x}", ("x",int64_t(this)) );
-   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
-                                             on_objects_new(ids, impacted_accounts);
-                                            });
-   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
-                                on_objects_changed(ids, impacted_accounts);
-                                });
-   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
-                                                     on_objects_removed(ids, objs, impacted_accounts);
-                                                   });
+   _notification_hub->add_session(this);
    _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
+   // shared by all sessions, the first one registers it and the values are built with every block from then on
+   _db.snapshots().add<vector<reward_queue_object>>( "get_reward_queue", [&db]() {
+      return database_access_layer( db ).get_reward_queue();
+   });
 
    _pending_trx_connection = _db.on_pending_transaction.connect([this](const signed_transaction& trx ){
                          if( _pending_trx_callback ) _pending_trx_callback( fc::variant(trx) );
@@ -419,6 +403,7 @@ database_api_impl::database_api_impl( graphene::chain::database& db ): _db(db),
 database_api_impl::~database_api_impl()
 {
    elog("freeing database api ${x}", ("x",int64_t(this)) );
+   _notification_hub->remove_session(this);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -454,7 +439,7 @@ fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)co
    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
                   [this](object_id_type id) -> fc::variant {
       if(auto obj = _db.find_object(id))
-         return obj->to_variant();
+         return _db.object_to_variant(*obj);
       return {};
    });
 
@@ -477,13 +462,8 @@ void database_api_impl::set_subscribe_callback( std::function<void(const variant
 //   edump((clear_filter));
    _subscribe_callback = cb;
    _notify_remove_create = notify_remove_create;
-   _subscribed_accounts.clear();
-   static fc::bloom_parameters param;
-   param.projected_element_count    = 10000;
-   param.false_positive_probability = 1.0/100;
-   param.maximum_size = 1024*8*8*2;
-   param.compute_optimal_parameters();
-   _subscribe_filter = fc::bloom_filter(param);
+   _notification_hub->unsubscribe_from_accounts(this);
+   _notification_hub->unsubscribe_from_items(this);
 }
 
 void database_api::set_pending_transaction_callback( std::function<void(const variant&)> cb )
@@ -517,6 +497,16 @@ void database_api_impl::cancel_all_subscriptions()
    _market_subscriptions.clear();
 }
 
+notification_hub_statistics database_api::get_subscription_statistics()const
+{
+   return my->get_subscription_statistics();
+}
+
+notification_hub_statistics database_api_impl::get_subscription_statistics()const
+{
+   return _notification_hub->get_statistics();
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Blocks and transactions                                          //
@@ -653,21 +643,23 @@ optional<total_cycles_res> database_api::get_total_cycles() const {
 }
 
 optional<total_cycles_res> database_api_impl::get_total_cycles() const {
-    total_cycles_res result;
-    const auto& accounts = _db.get_index_type<account_index>().indices().get<by_id>();
-
-    for (const account_object& acc : accounts)
+    const auto& idx = _db.get_index_type<license_information_index>();
+    const auto& lidx = dynamic_cast<const primary_index<license_information_index>&>(idx);
+    const auto& totals = lidx.get_secondary_index<graphene::chain::license_total_cycles_index>();
+    total_cycles_res result(totals.total_cycles(), totals.total_dascoin());
+
+#ifndef NDEBUG
+    // The maintained totals have to match the sum over all license information objects:
+    share_type cycles, dascoin, all_cycles = 0, all_dascoin = 0;
+    for (const license_information_object& lio : idx)
     {
-        if (acc.is_vault())
-        {
-            optional<total_cycles_res> vaultCycles = _dal.get_total_cycles(acc.get_id());     
-            if (vaultCycles.valid())
-            {
-                result.total_cycles += vaultCycles->total_cycles;
-                result.total_dascoin += vaultCycles->total_dascoin;
-            }
-        }
+        totals.get_contribution(lio, cycles, dascoin);
+        all_cycles += cycles;
+        all_dascoin += dascoin;
     }
+    assert( all_cycles == result.total_cycles && all_dascoin == result.total_dascoin );
+#endif
+
     return result;
 }
 
@@ -794,8 +786,7 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
       if( subscribe )
       {
-         FC_ASSERT( std::distance(_subscribed_accounts.begin(), _subscribed_accounts.end()) < 100 );
-         _subscribed_accounts.insert( account->get_id() );
+         _notification_hub->subscribe_to_account( this, account->get_id() );
          subscribe_to_item( account->id );
       }
 
@@ -835,8 +826,11 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
       auto balance_range = _db.get_index_type<account_balance_index>().indices().get<by_account_asset>().equal_range(boost::make_tuple(account->id));
       //vector<account_balance_object> balances;
       std::for_each(balance_range.first, balance_range.second,
-                    [&acnt](const account_balance_object& balance) {
+                    [&acnt, this](const account_balance_object& balance) {
                        acnt.balances.emplace_back(balance);
+                       // Report the spending limit of the current limit interval:
+                       acnt.balances.back().limit = _db.get_spending_limit(balance);
+                       acnt.balances.back().spent = _db.get_spent_amount(balance);
                     });
 
       // Add the account's vesting balances
@@ -2580,7 +2574,8 @@ vector<reward_queue_object> database_api::get_reward_queue() const
 
 vector<reward_queue_object> database_api_impl::get_reward_queue() const
 {
-   return _dal.get_reward_queue();
+   auto queue = _db.snapshots().get<vector<reward_queue_object>>("get_reward_queue");
+   return queue ? *queue : _dal.get_reward_queue();
 }
 vector<reward_queue_object> database_api::get_reward_queue_by_page(uint32_t from, uint32_t amount) const
 {
@@ -2698,39 +2693,21 @@ vector<dasc_holder> database_api::get_top_dasc_holders() const
 vector<dasc_holder> database_api_impl::get_top_dasc_holders() const
 {
     static const uint32_t max_holders = 100;
-    vector<dasc_holder> tmp;
-    const auto& dasc_id = _db.get_dascoin_asset_id();
-    const auto& idx = _db.get_index_type<account_index>().indices().get<by_id>();
-    for ( auto it = idx.cbegin(); it != idx.cend(); ++it )
+    const auto& idx = _db.get_index_type<account_balance_index>();
+    const auto& bidx = dynamic_cast<const primary_index<account_balance_index>&>(idx);
+    const auto& holders = bidx.get_secondary_index<graphene::chain::dasc_holder_index>();
+
+    vector<dasc_holder> result;
+    for ( const auto& entry : holders.top(max_holders) )
     {
-        const auto& account = *it;
+        const auto& account = entry.first(_db);
         dasc_holder holder;
         holder.holder = account.id;
-        if (account.kind == account_kind::wallet)
-        {
-            holder.vaults = account.vault.size();
-            const auto& balance_obj = _db.get_balance_object(account.id, dasc_id);
-            holder.amount = balance_obj.balance;
-            std::for_each(account.vault.begin(), account.vault.end(), [this, &holder, &dasc_id](const account_id_type& vault_id) {
-                const auto& balance_obj = _db.get_balance_object(vault_id, dasc_id);
-                holder.amount += balance_obj.balance;
-            });
-            tmp.emplace_back(holder);
-        }
-        else if (account.kind == account_kind::custodian || (account.kind == account_kind::vault && account.parents.empty()))
-        {
-            holder.vaults = 0;
-            const auto& balance_obj = _db.get_balance_object(account.id, dasc_id);
-            holder.amount = balance_obj.balance;
-            tmp.emplace_back(holder);
-        }
+        holder.vaults = account.is_wallet() ? account.vault.size() : 0;
+        holder.amount = entry.second;
+        result.emplace_back(holder);
     }
-
-    std::partial_sort(tmp.begin(), tmp.begin() + max_holders, tmp.end(), [](dasc_holder& a, dasc_holder& b) {
-        return a.amount > b.amount;
-    });
-    vector<dasc_holder> ret(tmp.begin(), tmp.begin() + max_holders);
-    return ret;
+    return result;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -2803,6 +2780,11 @@ vector<das33_pledge_holder_object> database_api::get_das33_pledges_by_account(ac
     return my->get_das33_pledges_by_account(account);
 }
 
+vector<das33_pledge_holder_object> database_api::get_das33_pledges_by_account_paged(account_id_type account, das33_pledge_holder_id_type from, uint32_t limit) const
+{
+    return my->get_das33_pledges_by_account_paged(account, from, limit);
+}
+
 vector<das33_pledge_holder_object> database_api::get_das33_pledges_by_project(das33_project_id_type project, das33_pledge_holder_id_type from, uint32_t limit) const
 {
     return my->get_das33_pledges_by_project(project, from, limit);
@@ -2835,15 +2817,42 @@ vector<das33_pledge_holder_object> database_api_impl::get_das33_pledges_by_accou
     return result;
 }
 
+vector<das33_pledge_holder_object> database_api_impl::get_das33_pledges_by_account_paged(account_id_type account, das33_pledge_holder_id_type from, uint32_t limit) const
+{
+    FC_ASSERT( limit <= 100 );
+    vector<das33_pledge_holder_object> result;
+    result.reserve(limit);
+
+    const auto& pledges = _db.get_index_type<das33_pledge_holder_index>().indices().get<by_user>();
+    auto itr = pledges.lower_bound(account);
+
+    // Resume right at the cursor pledge, if it belongs to this account:
+    const auto& by_id_idx = _db.get_index_type<das33_pledge_holder_index>().indices().get<by_id>();
+    const auto cursor = by_id_idx.find(from);
+    if( cursor != by_id_idx.end() && cursor->account_id == account )
+       itr = pledges.lower_bound(make_tuple(account, cursor->project_id, cursor->id));
+
+    auto default_pledge_id = das33_pledge_holder_id_type();
+
+    for( ; limit-- && itr != pledges.end() && itr->account_id == account; ++itr )
+    {
+       if (itr->id != default_pledge_id)
+          result.emplace_back(*itr);
+    }
+
+    return result;
+}
+
 vector<das33_pledge_holder_object> database_api_impl::get_das33_pledges_by_project(das33_project_id_type project, das33_pledge_holder_id_type from, uint32_t limit) const
 {
     FC_ASSERT( limit <= 100 );
     vector<das33_pledge_holder_object> result;
+    result.reserve(limit);
 
     auto default_pledge_id = das33_pledge_holder_id_type();
 
     const auto& pledges = _db.get_index_type<das33_pledge_holder_index>().indices().get<by_project>();
-    for( auto itr = pledges.lower_bound(make_tuple(project, from)); limit-- && itr->project_id == project && itr != pledges.end(); ++itr )
+    for( auto itr = pledges.lower_bound(make_tuple(project, from)); limit-- && itr != pledges.end() && itr->project_id == project; ++itr )
     {
        if (itr->id != default_pledge_id)
           result.emplace_back(*itr);
@@ -2885,17 +2894,34 @@ vector<das33_project_object> database_api_impl::get_das33_projects(const string&
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-void database_api_impl::broadcast_updates( const vector<variant>& updates )
+void database_api_impl::broadcast_updates( vector<variant>&& updates )
 {
    if( updates.size() && _subscribe_callback ) {
+      _pending_updates.emplace_back( std::move(updates) );
+      if( _flush_scheduled )
+         return;
+
+      // Sending is left to a task of its own, a single one for everything queued until it runs:
+      _flush_scheduled = true;
       auto capture_this = shared_from_this();
-      fc::async([capture_this,updates](){
-          if(capture_this->_subscribe_callback)
-             capture_this->_subscribe_callback( fc::variant(updates) );
+      fc::async([capture_this](){
+          capture_this->flush_updates();
       });
    }
 }
 
+void database_api_impl::flush_updates()
+{
+   _flush_scheduled = false;
+   std::deque<fc::variant> updates;
+   updates.swap(_pending_updates);
+   for( const auto& item : updates )
+   {
+      if(_subscribe_callback)
+         _subscribe_callback( item );
+   }
+}
+
 void database_api_impl::broadcast_market_updates( const market_queue_type& queue)
 {
    if( queue.size() )
@@ -2912,73 +2938,56 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
    }
 }
 
-void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts )
-{
-   handle_object_changed(_notify_remove_create, false, ids, impacted_accounts, 
-      [objs](object_id_type id) -> const object* {
-         auto it = std::find_if(objs.begin(), objs.end(), [id](const object* o) {return o != nullptr && o->id == id;});
-         if (it != objs.end())
-         {
-            return *it;
-         }
-         return nullptr;
-   });
-}
-
-void database_api_impl::on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
+void database_api_impl::on_objects_notification( const object_notification_batch& batch, bool account_impacted,
+                                                 const vector<size_t>& subscribed_items )
 {
-   handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
-}
+   const auto& ids = batch.ids();
+   const bool full_object = batch.kind() != notification_kind::removed_objects;
+   const bool force_notify = batch.kind() != notification_kind::changed_objects && _notify_remove_create;
 
-void database_api_impl::on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
-{
-   handle_object_changed(false, true, ids, impacted_accounts,
-      std::bind(&object_database::find_object, &_db, std::placeholders::_1)
-   );
-}
-
-void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object)
-{
    if( _subscribe_callback )
    {
       vector<variant> updates;
+      updates.reserve(ids.size());
 
-      for(auto id : ids)
+      auto subscribed_itr = subscribed_items.begin();
+      for( size_t i = 0; i < ids.size(); ++i )
       {
-         const object* obj = nullptr;
-         if( force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts) )
+         const bool subscribed = subscribed_itr != subscribed_items.end() && *subscribed_itr == i;
+         if( subscribed )
+            ++subscribed_itr;
+
+         if( force_notify || account_impacted || subscribed )
          {
             if ( full_object )
             {
-               obj = find_object(id);
-               if( obj )
+               const auto& payload = batch.get_payload(i);
+               if( !payload.is_null() )
                {
-                  updates.emplace_back( obj->to_variant() );
+                  updates.emplace_back( payload );
                }
             }
          }
          else
          {
-            updates.emplace_back( id );
+            updates.emplace_back( ids[i] );
          }
       }
-      broadcast_updates(updates);
+      broadcast_updates(std::move(updates));
    }
    if( _market_subscriptions.size() )
    {
       market_queue_type broadcast_queue;
 
-      for(auto id : ids)
+      for( size_t i = 0; i < ids.size(); ++i )
       {
-         if( id.is<call_order_object>() )
+         if( ids[i].is<call_order_object>() )
          {
-            enqueue_if_subscribed_to_market<call_order_object>( find_object(id), broadcast_queue, full_object );
+            enqueue_if_subscribed_to_market<call_order_object>( batch, i, broadcast_queue, full_object );
          }
-         else if( id.is<limit_order_object>() )
+         else if( ids[i].is<limit_order_object>() )
          {
-            enqueue_if_subscribed_to_market<limit_order_object>( find_object(id), broadcast_queue, full_object );
+            enqueue_if_subscribed_to_market<limit_order_object>( batch, i, broadcast_queue, full_object );
          }
       }
 
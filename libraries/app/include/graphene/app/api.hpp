@@ -123,6 +123,23 @@ namespace graphene { namespace app {
                                                                         uint32_t stop = 0,
                                                                         unsigned limit = 100,
                                                                         uint32_t start = 0) const;
+         /**
+          * @brief Get operations of given types relevant to the specified account, referenced
+          * by an event numbering specific to the account.
+          * @param account The account whose history should be queried
+          * @param operation_types Operation types whose history should be queried
+          * @param stop Sequence number of earliest operation. 0 is default and will
+          * query 'limit' number of operations.
+          * @param limit Maximum number of operations to retrieve (must not exceed 100)
+          * @param start Sequence number of the most recent operation to retrieve.
+          * 0 is default, which will start querying from the most recent operation.
+          * @return A list of operations performed by account, ordered from most recent to oldest.
+          */
+         vector<operation_history_object> get_relative_account_history_by_operation( account_id_type account,
+                                                                                     flat_set<uint32_t> operation_types,
+                                                                                     uint32_t stop = 0,
+                                                                                     unsigned limit = 100,
+                                                                                     uint32_t start = 0) const;
 
          vector<order_history_object> get_fill_order_history( asset_id_type a, asset_id_type b, uint32_t limit )const;
          vector<bucket_object> get_market_history( asset_id_type a, asset_id_type b, uint32_t bucket_seconds,
@@ -130,11 +147,18 @@ namespace graphene { namespace app {
          flat_set<uint32_t> get_market_history_buckets()const;
 
       protected:
-         vector<operation_history_object> get_account_history_impl(account_id_type account,
-                                                                   const std::function<bool(const account_transaction_history_object* node)> &selector,
-                                                                   operation_history_id_type stop = operation_history_id_type(),
-                                                                   unsigned limit = 100,
-                                                                   operation_history_id_type start = operation_history_id_type())const;
+         /// @return the sequence number of the account's most recent operation with an id not above op_id, 0 if none
+         uint32_t get_account_sequence( account_id_type account, operation_history_id_type op_id )const;
+
+         /**
+          *  Operations of the given types, or of all types if operation_types is nullptr, with a sequence number in
+          *  (stop, start], newest first. Entries moved out of memory are read from the cold history store.
+          */
+         vector<operation_history_object> get_account_history_by_sequence( account_id_type account,
+                                                                           const flat_set<uint32_t>* operation_types,
+                                                                           uint32_t stop,
+                                                                           unsigned limit,
+                                                                           uint32_t start )const;
 
       private:
          application& _app;
@@ -336,6 +360,7 @@ FC_API(graphene::app::history_api,
        (get_account_history)
        (get_account_history_by_operation)
        (get_relative_account_history)
+       (get_relative_account_history_by_operation)
        (get_fill_order_history)
        (get_market_history)
        (get_market_history_buckets)
@@ -34,6 +34,7 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class notification_hub;
 
    class application
    {
@@ -79,6 +80,10 @@ namespace graphene { namespace app {
 
          net::node_ptr                    p2p_node();
          std::shared_ptr<chain::database> chain_database()const;
+         /// Dispatches the object notifications of the chain database to all database API sessions
+         std::shared_ptr<notification_hub> chain_notifications()const;
+         /// The directory passed to initialize(), holding the databases and the configuration of the node
+         const fc::path&                  data_dir()const;
 
          void set_block_production(bool producing_blocks);
          fc::optional< api_access_info > get_api_access_info( const string& username )const;
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/full_account.hpp>
+#include <graphene/app/notification_hub.hpp>
 
 #include <graphene/chain/protocol/types.hpp>
 
@@ -186,7 +187,7 @@ struct daspay_authority
 class database_api
 {
    public:
-      database_api(graphene::chain::database& db);
+      database_api(graphene::chain::database& db, std::shared_ptr<notification_hub> hub);
       ~database_api();
 
       /////////////
@@ -215,6 +216,11 @@ class database_api
        * This unsubscribes from all subscribed markets and objects.
        */
       void cancel_all_subscriptions();
+      /**
+       * @brief Get the size of the subscription registry shared by all sessions of this node
+       * @return number of sessions and subscriptions, along with counters of the notification dispatch work
+       */
+      notification_hub_statistics get_subscription_statistics()const;
 
       /////////////////////////////
       // Blocks and transactions //
@@ -819,7 +825,7 @@ class database_api
       vector<acc_id_share_t_res> get_dascoin_balances_for_accounts(vector<account_id_type> ids) const;
 
       /**
-       * @brief Return the entire reward queue.
+       * @brief Return the entire reward queue, as of the last applied block.
        * @return Vector of all reward queue objects.
        */
       vector<reward_queue_object> get_reward_queue() const;
@@ -944,6 +950,16 @@ class database_api
       */
       vector<das33_pledge_holder_object> get_das33_pledges_by_account(account_id_type account) const;
 
+      /**
+      * @brief Get das33 pledges made by an account, one page at a time
+      * @params account id of account
+      * @params from the pledge to start with, which is included in the result. To get the next page, pass the last
+      *         pledge returned and skip it, it is returned again. A pledge of another account starts at the beginning.
+      * @params limit number of pledges to return, max 100
+      * @return vector of das33 pledge objects, ordered by project and id
+      */
+      vector<das33_pledge_holder_object> get_das33_pledges_by_account_paged(account_id_type account, das33_pledge_holder_id_type from, uint32_t limit) const;
+
       /**
       * @brief Get das33 pledges for a project
       * @params project id of a project
@@ -989,6 +1005,7 @@ FC_API( graphene::app::database_api,
    (set_pending_transaction_callback)
    (set_block_applied_callback)
    (cancel_all_subscriptions)
+   (get_subscription_statistics)
 
    // Blocks and transactions
    (get_block_header)
@@ -1129,6 +1146,7 @@ FC_API( graphene::app::database_api,
    // Das33
    (get_das33_pledges)
    (get_das33_pledges_by_account)
+   (get_das33_pledges_by_account_paged)
    (get_das33_pledges_by_project)
    (get_das33_projects)
 )
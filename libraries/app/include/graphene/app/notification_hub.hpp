@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/variant.hpp>
+
+#include <boost/signals2/connection.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace graphene { namespace app {
+
+using namespace graphene::chain;
+
+enum class notification_kind
+{
+   new_objects,
+   changed_objects,
+   removed_objects
+};
+
+/**
+ *  @brief One batch of object notifications reported by the database.
+ *
+ *  The variant of an object is built the first time a session asks for it, and is then shared by every other session
+ *  notified of the same object.
+ */
+class object_notification_batch
+{
+   public:
+      object_notification_batch( const database& db, notification_kind kind, const vector<object_id_type>& ids,
+                                 std::function<const object*(size_t)> find_object );
+
+      notification_kind kind()const { return _kind; }
+      const vector<object_id_type>& ids()const { return _ids; }
+
+      /// @return the i-th object of the batch, or nullptr if it no longer exists
+      const object* get_object( size_t i )const;
+      /// @return the i-th object of the batch as database::object_to_variant reports it, null if it no longer exists
+      const fc::variant& get_payload( size_t i )const;
+
+   private:
+      const database&                                _db;
+      notification_kind                              _kind;
+      const vector<object_id_type>&                  _ids;
+      std::function<const object*(size_t)>           _find_object;
+      mutable vector<fc::variant>                    _payloads;
+      mutable vector<bool>                           _payload_ready;
+};
+
+/**
+ *  @brief A database API session receiving object notifications from the hub.
+ */
+class notification_session
+{
+   public:
+      virtual ~notification_session() = default;
+
+      /**
+       *  Called on the chain thread for every batch. Implementations should only select and queue updates here,
+       *  the delivery to the client has to happen later.
+       *  @param account_impacted true if the batch impacts one of the accounts the session is subscribed to
+       *  @param subscribed_items positions in the batch of the objects the session is subscribed to, ascending
+       */
+      virtual void on_objects_notification( const object_notification_batch& batch, bool account_impacted,
+                                            const vector<size_t>& subscribed_items ) = 0;
+};
+
+/**
+ *  @brief Size of the subscription registry and the work done dispatching notifications.
+ */
+struct notification_hub_statistics
+{
+   uint32_t sessions = 0;
+   uint32_t subscribed_accounts = 0;  ///< distinct accounts with at least one subscribed session
+   uint32_t subscribed_items = 0;     ///< distinct objects with at least one subscribed session
+   uint64_t batches = 0;              ///< notification batches dispatched
+   uint64_t notified_objects = 0;     ///< objects in all dispatched batches
+   uint64_t item_matches = 0;         ///< (object, subscribed session) pairs found while dispatching
+};
+
+/**
+ *  @brief Fans the object notifications of the database out to all database API sessions.
+ *
+ *  The application owns the hub of its chain database and hands it to every database API it creates. The hub is the
+ *  only listener of the database object signals, no matter how many sessions are connected. It keeps exact inverted
+ *  indexes from accounts and from objects to the sessions subscribed to them, so matching a batch costs one lookup per
+ *  notified object and impacted account, plus one per match, instead of asking every session.
+ */
+class notification_hub
+{
+   public:
+      explicit notification_hub( database& db );
+
+      void add_session( notification_session* session );
+      void remove_session( notification_session* session );
+
+      /// Subscribes the session to the account, a session can be subscribed to max_accounts_per_session accounts.
+      void subscribe_to_account( notification_session* session, account_id_type account );
+      void unsubscribe_from_accounts( notification_session* session );
+
+      /**
+       *  Subscribes the session to the object. Once the session has max_items_per_session subscriptions further
+       *  objects are not subscribed to, which is logged once per session; the read asking for them still succeeds.
+       */
+      void subscribe_to_item( const notification_session* session, object_id_type id );
+      bool is_subscribed_to_item( const notification_session* session, object_id_type id )const;
+      void unsubscribe_from_items( const notification_session* session );
+
+      notification_hub_statistics get_statistics()const;
+
+      static const size_t max_accounts_per_session = 100;
+      static const size_t max_items_per_session = 10000;
+
+   private:
+      void dispatch( const object_notification_batch& batch, const flat_set<account_id_type>& impacted_accounts );
+
+      database&                                                   _db;
+      flat_set<notification_session*>                             _sessions;
+      std::map< account_id_type, flat_set<notification_session*> > _account_sessions;
+      std::map< notification_session*, flat_set<account_id_type> > _session_accounts;
+
+      std::unordered_map< object_id_type, flat_set<const notification_session*> >                _item_sessions;
+      std::unordered_map< const notification_session*, std::unordered_set<object_id_type> >    _session_items;
+      /// sessions that reached max_items_per_session since they last dropped their object subscriptions
+      std::unordered_set<const notification_session*>                                           _sessions_at_item_limit;
+
+      uint64_t                                                    _batches = 0;
+      uint64_t                                                    _notified_objects = 0;
+      uint64_t                                                    _item_matches = 0;
+
+      boost::signals2::scoped_connection                          _new_connection;
+      boost::signals2::scoped_connection                          _change_connection;
+      boost::signals2::scoped_connection                          _removed_connection;
+};
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::notification_hub_statistics,
+            (sessions)
+            (subscribed_accounts)
+            (subscribed_items)
+            (batches)
+            (notified_objects)
+            (item_matches)
+          )
@@ -0,0 +1,207 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <graphene/app/notification_hub.hpp>
+
+namespace graphene { namespace app {
+
+const size_t notification_hub::max_accounts_per_session;
+const size_t notification_hub::max_items_per_session;
+
+object_notification_batch::object_notification_batch( const database& db, notification_kind kind,
+                                                      const vector<object_id_type>& ids,
+                                                      std::function<const object*(size_t)> find_object )
+   : _db( db ),
+     _kind( kind ),
+     _ids( ids ),
+     _find_object( std::move( find_object ) ),
+     _payloads( ids.size() ),
+     _payload_ready( ids.size(), false )
+{}
+
+const object* object_notification_batch::get_object( size_t i )const
+{
+   return _find_object( i );
+}
+
+const fc::variant& object_notification_batch::get_payload( size_t i )const
+{
+   if( !_payload_ready[i] )
+   {
+      if( const object* obj = get_object( i ) )
+         _payloads[i] = _db.object_to_variant( *obj );
+      _payload_ready[i] = true;
+   }
+   return _payloads[i];
+}
+
+notification_hub::notification_hub( database& db ) : _db(db)
+{
+   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
+      dispatch( object_notification_batch( _db, notification_kind::new_objects, ids,
+                   [this, &ids](size_t i) { return _db.find_object( ids[i] ); } ), impacted_accounts );
+   });
+   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
+      dispatch( object_notification_batch( _db, notification_kind::changed_objects, ids,
+                   [this, &ids](size_t i) { return _db.find_object( ids[i] ); } ), impacted_accounts );
+   });
+   // The database reports every removed object next to its id:
+   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
+      dispatch( object_notification_batch( _db, notification_kind::removed_objects, ids,
+                   [&objs](size_t i) { return i < objs.size() ? objs[i] : nullptr; } ), impacted_accounts );
+   });
+}
+
+void notification_hub::add_session( notification_session* session )
+{
+   _sessions.insert( session );
+}
+
+void notification_hub::remove_session( notification_session* session )
+{
+   unsubscribe_from_accounts( session );
+   unsubscribe_from_items( session );
+   _sessions.erase( session );
+}
+
+void notification_hub::subscribe_to_account( notification_session* session, account_id_type account )
+{
+   auto& accounts = _session_accounts[session];
+   FC_ASSERT( accounts.size() < max_accounts_per_session || accounts.find( account ) != accounts.end(),
+              "A session can not be subscribed to more than ${n} accounts", ("n", max_accounts_per_session) );
+   accounts.insert( account );
+   _account_sessions[account].insert( session );
+}
+
+void notification_hub::unsubscribe_from_accounts( notification_session* session )
+{
+   auto itr = _session_accounts.find( session );
+   if( itr == _session_accounts.end() )
+      return;
+
+   for( const auto& account : itr->second )
+   {
+      auto account_itr = _account_sessions.find( account );
+      account_itr->second.erase( session );
+      if( account_itr->second.empty() )
+         _account_sessions.erase( account_itr );
+   }
+   _session_accounts.erase( itr );
+}
+
+void notification_hub::subscribe_to_item( const notification_session* session, object_id_type id )
+{
+   auto& items = _session_items[session];
+   if( items.find( id ) != items.end() )
+      return;
+   if( items.size() >= max_items_per_session )
+   {
+      if( _sessions_at_item_limit.insert( session ).second )
+         wlog( "A session reached ${n} object subscriptions, further objects are not subscribed to",
+               ("n", max_items_per_session) );
+      return;
+   }
+   items.insert( id );
+   _item_sessions[id].insert( session );
+}
+
+bool notification_hub::is_subscribed_to_item( const notification_session* session, object_id_type id )const
+{
+   auto itr = _session_items.find( session );
+   return itr != _session_items.end() && itr->second.find( id ) != itr->second.end();
+}
+
+void notification_hub::unsubscribe_from_items( const notification_session* session )
+{
+   _sessions_at_item_limit.erase( session );
+   auto itr = _session_items.find( session );
+   if( itr == _session_items.end() )
+      return;
+
+   for( const auto& id : itr->second )
+   {
+      auto item_itr = _item_sessions.find( id );
+      item_itr->second.erase( session );
+      if( item_itr->second.empty() )
+         _item_sessions.erase( item_itr );
+   }
+   _session_items.erase( itr );
+}
+
+notification_hub_statistics notification_hub::get_statistics()const
+{
+   notification_hub_statistics result;
+   result.sessions = _sessions.size();
+   result.subscribed_accounts = _account_sessions.size();
+   result.subscribed_items = _item_sessions.size();
+   result.batches = _batches;
+   result.notified_objects = _notified_objects;
+   result.item_matches = _item_matches;
+   return result;
+}
+
+void notification_hub::dispatch( const object_notification_batch& batch, const flat_set<account_id_type>& impacted_accounts )
+{
+   if( _sessions.empty() )
+      return;
+
+   ++_batches;
+   _notified_objects += batch.ids().size();
+
+   flat_set<notification_session*> impacted_sessions;
+   if( !_account_sessions.empty() )
+   {
+      for( const auto& account : impacted_accounts )
+      {
+         auto itr = _account_sessions.find( account );
+         if( itr != _account_sessions.end() )
+            impacted_sessions.insert( itr->second.begin(), itr->second.end() );
+      }
+   }
+
+   // Walk the batch once and collect, per session, the positions of the objects it is subscribed to:
+   std::map< const notification_session*, vector<size_t> > subscribed_items;
+   if( !_item_sessions.empty() )
+   {
+      const auto& ids = batch.ids();
+      for( size_t i = 0; i < ids.size(); ++i )
+      {
+         auto itr = _item_sessions.find( ids[i] );
+         if( itr == _item_sessions.end() )
+            continue;
+         for( const auto* session : itr->second )
+            subscribed_items[session].push_back( i );
+         _item_matches += itr->second.size();
+      }
+   }
+
+   static const vector<size_t> none;
+   for( auto* session : _sessions )
+   {
+      auto itr = subscribed_items.find( session );
+      session->on_objects_notification( batch, impacted_sessions.find( session ) != impacted_sessions.end(),
+                                        itr == subscribed_items.end() ? none : itr->second );
+   }
+}
+
+} } // graphene::app
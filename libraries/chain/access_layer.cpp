@@ -106,7 +106,7 @@ acc_id_share_t_res database_access_layer::get_dascoin_balance(account_id_type id
 
 acc_id_vec_cycle_agreement_res database_access_layer::get_all_cycle_balances(account_id_type id) const
 {
-    if (!get_opt<account_id_type, account_index, by_id>(id).valid())
+    if (_db.find(id) == nullptr)
         // TODO: ugly, figure out a way to use braces.
         return {id};  // Account with said id does not exist, return empty optional.
 
@@ -148,8 +148,8 @@ vector<acc_id_share_t_res> database_access_layer::get_dascoin_balances_for_accou
 
 optional<total_cycles_res> database_access_layer::get_total_cycles(account_id_type vault_id) const
 {
-    const auto& account = get_opt<account_id_type, account_index, by_id>(vault_id);
-    if (account.valid() && account->is_vault())
+    const account_object* account = _db.find(vault_id);
+    if (account != nullptr && account->is_vault())
     {
         auto license_information = _db.get_license_information(vault_id);
         if (license_information.valid() && license_information->is_manual_submit()) 
@@ -223,7 +223,7 @@ vector<reward_queue_object> database_access_layer::get_reward_queue() const
 
 vector<reward_queue_object> database_access_layer::get_reward_queue_by_page(uint32_t from, uint32_t amount) const
 {
-    return get_range<reward_queue_index, by_time>(from, amount);
+    return get_ranked_range<reward_queue_index, by_time>(from, amount);
 }
 
 vector<frequency_history_record_object> database_access_layer::get_frequency_history() const
@@ -238,7 +238,7 @@ vector<frequency_history_record_object> database_access_layer::get_frequency_his
 
 acc_id_queue_subs_w_pos_res database_access_layer::get_queue_submissions_with_pos(account_id_type account_id) const
 {
-    if (!get_opt<account_id_type, account_index, by_id>(account_id).valid())
+    if (_db.find(account_id) == nullptr)
         return {account_id};  // Account does not exist, return null result.
 
     vector<sub_w_pos> result;
@@ -249,7 +249,7 @@ acc_id_queue_subs_w_pos_res database_access_layer::get_queue_submissions_with_po
 
     const auto& range = account_idx.equal_range(account_id);
     for (auto it = range.first; it != range.second; ++it) {
-        uint32_t pos = distance(time_idx.begin(), queue_multi_idx.project<by_time>(it));
+        uint32_t pos = time_idx.rank(queue_multi_idx.project<by_time>(it));
         result.emplace_back(pos, *it);
     }
 
@@ -265,10 +265,10 @@ vector<acc_id_queue_subs_w_pos_res>
 
 optional<vault_info_res> database_access_layer::get_vault_info(account_id_type vault_id) const
 {
-    const auto& account = get_opt<account_id_type, account_index, by_id>(vault_id);
+    const account_object* account = _db.find(vault_id);
 
     // TODO: re-evaluate this, should we throw an error here?
-    if (!account.valid() || !account->is_vault())
+    if (account == nullptr || !account->is_vault())
         return {};
 
     const auto& webeur_balance = _db.get_balance_object(vault_id, _db.get_web_asset_id());
@@ -281,9 +281,9 @@ optional<vault_info_res> database_access_layer::get_vault_info(account_id_type v
                           webeur_balance.reserved,
                           dascoin_balance.balance,
                           free_cycle_balance,
-                          dascoin_balance.limit,
+                          _db.get_spending_limit(dascoin_balance),
                           eur_limit,
-                          dascoin_balance.spent,
+                          _db.get_spent_amount(dascoin_balance),
                           account->is_tethered(),
                           account->owner_change_counter,
                           account->active_change_counter,
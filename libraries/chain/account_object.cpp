@@ -267,4 +267,200 @@ void account_referrer_index::object_modified( const object& after  )
 {
 }
 
+bool dasc_holder_index::is_holder( const account_object& a )
+{
+   return a.is_wallet() || a.is_custodian() || ( a.is_vault() && a.parents.empty() );
+}
+
+void dasc_holder_index::build()const
+{
+   const auto& accounts = _db.get_index_type<account_index>();
+   for( const account_object& a : accounts )
+   {
+      if( a.is_wallet() )
+         link_vaults( a.id, a.vault );
+      if( is_holder( a ) )
+         set_total( a.id, aggregated_balance( a ) );
+   }
+   _built = true;
+}
+
+share_type dasc_holder_index::aggregated_balance( const account_object& a )const
+{
+   const auto dasc_id = _db.get_dascoin_asset_id();
+   share_type result = _db.get_balance( a.id, dasc_id ).amount;
+   if( a.is_wallet() )
+      for( const auto& vault_id : a.vault )
+         result += _db.get_balance( vault_id, dasc_id ).amount;
+   return result;
+}
+
+void dasc_holder_index::set_total( account_id_type holder, share_type total )const
+{
+   auto itr = _totals.find( holder );
+   if( itr == _totals.end() )
+      itr = _totals.emplace( holder, total ).first;
+   else
+   {
+      _ranking.erase( std::make_pair( itr->second, holder ) );
+      itr->second = total;
+   }
+   _ranking.emplace( total, holder );
+}
+
+void dasc_holder_index::erase_total( account_id_type holder )const
+{
+   auto itr = _totals.find( holder );
+   if( itr == _totals.end() )
+      return;
+   _ranking.erase( std::make_pair( itr->second, holder ) );
+   _totals.erase( itr );
+}
+
+void dasc_holder_index::adjust( account_id_type account, share_type delta )const
+{
+   if( delta == 0 )
+      return;
+   auto itr = _totals.find( account );
+   if( itr != _totals.end() )
+      set_total( account, itr->second + delta );
+   auto wallets = _wallets_of_vault.find( account );
+   if( wallets != _wallets_of_vault.end() )
+      for( const auto& wallet_id : wallets->second )
+      {
+         auto wallet = _totals.find( wallet_id );
+         if( wallet != _totals.end() )
+            set_total( wallet_id, wallet->second + delta );
+      }
+}
+
+vector< std::pair<account_id_type, share_type> > dasc_holder_index::top( uint32_t count )const
+{
+   if( !_built )
+      build();
+   vector< std::pair<account_id_type, share_type> > result;
+   result.reserve( std::min<size_t>( count, _ranking.size() ) );
+   for( auto itr = _ranking.begin(); itr != _ranking.end() && result.size() < count; ++itr )
+      result.emplace_back( itr->second, itr->first );
+   return result;
+}
+
+void dasc_holder_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   if( _built && b.asset_type == _db.get_dascoin_asset_id() )
+      adjust( b.owner, b.balance );
+}
+
+void dasc_holder_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   if( _built && b.asset_type == _db.get_dascoin_asset_id() )
+      adjust( b.owner, -b.balance );
+}
+
+void dasc_holder_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const account_balance_object*>(&before) ); // for debug only
+   _before_balance = static_cast<const account_balance_object&>(before).balance;
+}
+
+void dasc_holder_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const account_balance_object*>(&after) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(after);
+   if( _built && b.asset_type == _db.get_dascoin_asset_id() )
+      adjust( b.owner, b.balance - _before_balance );
+}
+
+void dasc_holder_index::link_vaults( account_id_type wallet, const flat_set<account_id_type>& vaults )const
+{
+   for( const auto& vault_id : vaults )
+      _wallets_of_vault[vault_id].insert( wallet );
+}
+
+void dasc_holder_index::unlink_vaults( account_id_type wallet, const flat_set<account_id_type>& vaults )const
+{
+   for( const auto& vault_id : vaults )
+   {
+      auto itr = _wallets_of_vault.find( vault_id );
+      if( itr == _wallets_of_vault.end() )
+         continue;
+      itr->second.erase( wallet );
+      if( itr->second.empty() )
+         _wallets_of_vault.erase( itr );
+   }
+}
+
+void dasc_holder_index::account_inserted( const account_object& a )
+{
+   if( !_built )
+      return;
+   if( a.is_wallet() )
+      link_vaults( a.id, a.vault );
+   if( is_holder( a ) )
+      set_total( a.id, aggregated_balance( a ) );
+}
+
+void dasc_holder_index::account_removed( const account_object& a )
+{
+   if( !_built )
+      return;
+   if( a.is_wallet() )
+      unlink_vaults( a.id, a.vault );
+   erase_total( a.id );
+}
+
+void dasc_holder_index::account_about_to_modify( const account_object& before )
+{
+   _before_holder = is_holder( before );
+   _before_vaults.clear();
+   if( before.is_wallet() )
+      _before_vaults = before.vault;
+}
+
+void dasc_holder_index::account_modified( const account_object& after )
+{
+   if( !_built )
+      return;
+   const bool holder = is_holder( after );
+   const flat_set<account_id_type> no_vaults;
+   const auto& vaults = after.is_wallet() ? after.vault : no_vaults;
+   if( holder == _before_holder && vaults == _before_vaults )
+      return;
+
+   unlink_vaults( after.id, _before_vaults );
+   link_vaults( after.id, vaults );
+   if( holder )
+      set_total( after.id, aggregated_balance( after ) );
+   else
+      erase_total( after.id );
+}
+
+void dasc_holder_account_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   _holders.account_inserted( static_cast<const account_object&>(obj) );
+}
+
+void dasc_holder_account_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   _holders.account_removed( static_cast<const account_object&>(obj) );
+}
+
+void dasc_holder_account_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const account_object*>(&before) ); // for debug only
+   _holders.account_about_to_modify( static_cast<const account_object&>(before) );
+}
+
+void dasc_holder_account_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const account_object*>(&after) ); // for debug only
+   _holders.account_modified( static_cast<const account_object&>(after) );
+}
+
 } } // graphene::chain
@@ -25,6 +25,8 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/smart_ref_impl.hpp>
+#include <cstring>
+#include <fstream>
 
 namespace graphene { namespace chain {
 
@@ -39,23 +41,124 @@ FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
+namespace detail {
+
+void mapped_log_file::open( const fc::path& filename, uint64_t chunk_size )
+{
+   _filename   = filename;
+   _chunk_size = chunk_size;
+   if( !fc::exists( _filename ) )
+      std::ofstream( _filename.generic_string().c_str(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+
+   _file_size = fc::file_size( _filename );
+   _mapping.reset( new fc::file_mapping( _filename.generic_string().c_str(), fc::read_write ) );
+   _is_open = true;
+   if( _file_size > 0 )
+      map( _file_size );
+}
+
+void mapped_log_file::map( uint64_t size )
+{
+   _regions.emplace_back( new fc::mapped_region( *_mapping, fc::read_write, 0, size ) );
+   _capacity = size;
+   _data.store( (char*)_regions.back()->get_address(), std::memory_order_release );
+}
+
+void mapped_log_file::reserve( uint64_t new_size )
+{
+   if( new_size <= _capacity )
+      return;
+
+   uint64_t target = std::max( new_size, _capacity + _capacity / 2 );
+   target = ( target + _chunk_size - 1 ) / _chunk_size * _chunk_size;
+   if( target > _file_size )
+   {
+      fc::resize_file( _filename, target );
+      _file_size = target;
+   }
+   map( target );
+}
+
+void mapped_log_file::flush()
+{
+   if( !_regions.empty() )
+      _regions.back()->flush();
+}
+
+void mapped_log_file::close( uint64_t logical_size )
+{
+   flush();
+   _data.store( nullptr, std::memory_order_release );
+   _regions.clear();
+   _mapping.reset();
+   if( _file_size != logical_size )
+      fc::resize_file( _filename, logical_size );
+   _capacity  = 0;
+   _file_size = 0;
+   _is_open   = false;
+}
+
+} // detail
+
+// Both files are grown well ahead of the data, so that storing a block only rarely has to map a new region.
+static const uint64_t index_chunk_size  = 1024 * 1024;
+static const uint64_t blocks_chunk_size = 64 * 1024 * 1024;
+
+static signed_block unpack_block( const raw_block_view& view )
+{
+   fc::datastream<const char*> ds( view.data, view.size );
+   signed_block result;
+   fc::raw::unpack( ds, result );
+   FC_ASSERT( result.id() == view.id );
+   return result;
+}
+
+block_database::~block_database()
+{
+   try
+   {
+      if( is_open() )
+         close();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Error closing block database: ${e}", ("e", e.to_detail_string()) );
+   }
+}
+
 void block_database::open( const fc::path& dbdir )
 { try {
    fc::create_directories(dbdir);
-   _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
-   _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
-   if( !fc::exists( _index_filename ) )
+   _block_num_to_pos.open( _index_filename, index_chunk_size );
+   _blocks.open( dbdir / "blocks", blocks_chunk_size );
+
+   // The files are truncated to their logical sizes on close, but after an unclean shutdown they still
+   // carry the zero filled space they were grown by, so the logical sizes are recovered from the index.
+   char* index_data = _block_num_to_pos.data();
+   uint64_t index_size = _block_num_to_pos.file_size() - _block_num_to_pos.file_size() % sizeof(index_entry);
+   if( index_size < _block_num_to_pos.file_size() )
+      memset( index_data + index_size, 0, _block_num_to_pos.file_size() - index_size );
+
+   index_entry e;
+   while( index_size >= sizeof(e) )
    {
-     _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+      memcpy( (char*)&e, index_data + index_size - sizeof(e), sizeof(e) );
+      if( e.block_size > 0 || e.block_id != block_id_type() )
+         break;
+      index_size -= sizeof(e);
    }
-   else
+
+   uint64_t blocks_size = 0;
+   for( uint64_t pos = 0; pos < index_size; pos += sizeof(e) )
    {
-     _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+      memcpy( (char*)&e, index_data + pos, sizeof(e) );
+      blocks_size = std::max( blocks_size, e.block_pos + e.block_size );
    }
+
+   _index_size.store( index_size, std::memory_order_release );
+   _blocks_size.store( std::min( blocks_size, _blocks.file_size() ), std::memory_order_release );
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
 bool block_database::is_open()const
@@ -65,8 +168,12 @@ bool block_database::is_open()const
 
 void block_database::close()
 {
-  _blocks.close();
-  _block_num_to_pos.close();
+  if( !is_open() )
+     return;
+  _blocks.close( _blocks_size.load( std::memory_order_acquire ) );
+  _block_num_to_pos.close( _index_size.load( std::memory_order_acquire ) );
+  _blocks_size.store( 0, std::memory_order_release );
+  _index_size.store( 0, std::memory_order_release );
 }
 
 void block_database::flush()
@@ -83,48 +190,57 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       id = b.id();
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
-   _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(block_header::num_from_id(id)) );
+
+   // The block is packed straight into the mapped file and only then made visible to readers
+   // by publishing the new logical size, followed by the index entry pointing to it.
    index_entry e;
-   _blocks.seekp( 0, _blocks.end );
-   auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
-   e.block_size = vec.size();
+   e.block_pos  = _blocks_size.load( std::memory_order_relaxed );
+   e.block_size = fc::raw::pack_size( b );
    e.block_id   = id;
-   _blocks.write( vec.data(), vec.size() );
-   _block_num_to_pos.write( (char*)&e, sizeof(e) );
+   _blocks.reserve( e.block_pos + e.block_size );
+   fc::datastream<char*> ds( _blocks.data() + e.block_pos, e.block_size );
+   fc::raw::pack( ds, b );
+   _blocks_size.store( e.block_pos + e.block_size, std::memory_order_release );
+
+   const uint64_t index_pos = sizeof(e) * uint64_t(block_header::num_from_id(id));
+   _block_num_to_pos.reserve( index_pos + sizeof(e) );
+   memcpy( _block_num_to_pos.data() + index_pos, (const char*)&e, sizeof(e) );
+   if( _index_size.load( std::memory_order_relaxed ) < index_pos + sizeof(e) )
+      _index_size.store( index_pos + sizeof(e), std::memory_order_release );
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   const uint32_t block_num = block_header::num_from_id(id);
+   if( !read_index_entry( block_num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    if( e.block_id == id )
    {
       e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e) * int64_t(block_header::num_from_id(id)) );
-      _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      memcpy( _block_num_to_pos.data() + sizeof(e) * uint64_t(block_num), (const char*)&e, sizeof(e) );
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
+bool block_database::read_index_entry( uint32_t block_num, index_entry& e )const
+{
+   const uint64_t index_pos = sizeof(e) * uint64_t(block_num);
+   if( _index_size.load( std::memory_order_acquire ) < index_pos + sizeof(e) )
+      return false;
+
+   memcpy( (char*)&e, _block_num_to_pos.data() + index_pos, sizeof(e) );
+   return true;
+}
+
 bool block_database::contains( const block_id_type& id )const
 {
    if( id == block_id_type() )
       return false;
 
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() < int64_t(index_pos + sizeof(e)) )
+   if( !read_index_entry( block_header::num_from_id(id), e ) )
       return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
    return e.block_id == id && e.block_size > 0;
 }
@@ -133,40 +249,47 @@ block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
    index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_num);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   if( !read_index_entry( block_num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
    return e.block_id;
 }
 
+optional<raw_block_view> block_database::fetch_raw( const index_entry& e )const
+{
+   if( e.block_size == 0 || e.block_pos + e.block_size > _blocks_size.load( std::memory_order_acquire ) )
+      return optional<raw_block_view>();
+
+   raw_block_view view;
+   view.data = _blocks.data() + e.block_pos;
+   view.size = e.block_size;
+   view.id   = e.block_id;
+   return view;
+}
+
+optional<raw_block_view> block_database::fetch_raw( uint32_t block_num )const
+{
+   index_entry e;
+   if( !read_index_entry( block_num, e ) )
+      return optional<raw_block_view>();
+   return fetch_raw( e );
+}
+
 optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
    try
    {
       index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_index_entry( block_header::num_from_id(id), e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
       if( e.block_id != id ) return optional<signed_block>();
 
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      optional<raw_block_view> view = fetch_raw( e );
+      if( !view.valid() )
+         return optional<signed_block>();
+      return unpack_block( *view );
    }
    catch (const fc::exception&)
    {
@@ -181,21 +304,10 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
 {
    try
    {
-      index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_num);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      optional<raw_block_view> view = fetch_raw( block_num );
+      if( !view.valid() )
          return {};
-
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      return unpack_block( *view );
    }
    catch (const fc::exception& e)
    {
@@ -212,32 +324,19 @@ optional<index_entry> block_database::last_index_entry()const {
    {
       index_entry e;
 
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if( pos < long(sizeof(index_entry)) )
-         return optional<index_entry>();
-
-      pos -= pos % sizeof(index_entry);
-
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
+      uint64_t pos = _index_size.load( std::memory_order_acquire );
       while( pos > 0 )
       {
          pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size > 0
-                && int64_t(e.block_pos + e.block_size) <= blocks_size )
+         memcpy( (char*)&e, _block_num_to_pos.data() + pos, sizeof(e) );
+         if( e.block_size > 0 )
             try
             {
-               vector<char> data( e.block_size );
-               _blocks.seekg( e.block_pos );
-               _blocks.read( data.data(), e.block_size );
-               if( _blocks.gcount() == long(e.block_size) )
+               optional<raw_block_view> view = fetch_raw( e );
+               if( view.valid() )
                {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
+                  unpack_block( *view );
+                  return e;
                }
             }
             catch (const fc::exception&)
@@ -246,7 +345,9 @@ optional<index_entry> block_database::last_index_entry()const {
             catch (const std::exception&)
             {
             }
-         fc::resize_file( _index_filename, pos );
+         // drop the trailing entry which does not point to a valid block
+         _index_size.store( pos, std::memory_order_release );
+         memset( _block_num_to_pos.data() + pos, 0, sizeof(e) );
       }
    }
    catch (const fc::exception&)
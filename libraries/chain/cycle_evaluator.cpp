@@ -398,6 +398,7 @@ void_result purchase_cycles_evaluator::do_apply(const operation_type& op)
   auto& d = db();
 
   // Deduce dascoin from balance:
+  d.update_spending_limit(*_dascoin_balance_obj);
   d.modify(*_dascoin_balance_obj, [&](account_balance_object& acc_b){
     acc_b.balance -= op.amount.amount;
     acc_b.spent += op.amount.amount;
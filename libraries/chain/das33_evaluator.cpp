@@ -64,9 +64,8 @@ namespace graphene { namespace chain {
                 && op.token != d.get_dascoin_asset_id() && op.token != d.get_cycle_asset_id(), "Can not create project with system assets");
 
       // Check that token is not used by another project
-      const auto& it = std::find_if(idx.begin(), idx.end(),
-            [op](const das33_project_object& m) -> bool { return m.token_id == op.token; });
-      FC_ASSERT(it == idx.end(), "Token with id ${1} is already used by another project", ("1", op.token));
+      const auto& token_idx = d.get_index_type<das33_project_index>().indices().get<by_token>();
+      FC_ASSERT(token_idx.find(op.token) == token_idx.end(), "Token with id ${1} is already used by another project", ("1", op.token));
 
       prices_check(op.ratios, op.token);
 
@@ -240,6 +239,7 @@ namespace graphene { namespace chain {
     const auto& project_obj = op.project_id(d);
     d.modify(project_obj, [&](das33_project_object& p){
         p.collected += expected.amount;
+        p.total_pledged[op.pledged.asset_id] += op.pledged.amount;
     });
 
     // Create the holder object and return its ID:
@@ -325,6 +325,7 @@ namespace graphene { namespace chain {
   void_result das33_pledge_asset_evaluator::do_apply_asset(database &d, const das33_pledge_asset_operation &op, const account_balance_object &balance_obj) const {
 
     // Adjust the balance and spent amount:
+    d.update_spending_limit(balance_obj);
     d.modify(balance_obj, [&](account_balance_object& from){
       from.balance -= op.pledged.amount;
       from.spent += op.pledged.amount;
@@ -79,6 +79,8 @@ object_id_type database::create_empty_balance(account_id_type owner_id, asset_id
       abo.asset_type = asset_id;
       abo.balance = 0;
       abo.reserved = 0;
+      if ( asset_id == get_dascoin_asset_id() )
+         abo.limit_epoch = get_dynamic_global_properties().spend_limit_epoch;
    }).id;
 }
 
@@ -206,11 +208,13 @@ void database::adjust_balance(account_id_type account, asset delta, share_type r
                  ("a",account(*this).name)
                  ("b",to_pretty_string(asset(0,delta.asset_id)))
                  ("r",to_pretty_string(-asset(reserved_delta, delta.asset_id))));
-      create<account_balance_object>([account, &delta, reserved_delta](account_balance_object& b) {
+      create<account_balance_object>([this, account, &delta, reserved_delta](account_balance_object& b) {
          b.owner = account;
          b.asset_type = delta.asset_id;
          b.balance = delta.amount.value;
          b.reserved = reserved_delta;
+         if ( delta.asset_id == get_dascoin_asset_id() )
+            b.limit_epoch = get_dynamic_global_properties().spend_limit_epoch;
       });
    } else {
       if( delta.amount < 0 )
@@ -258,6 +262,7 @@ void database::adjust_balance_limit(const account_object& account, asset_id_type
    //            ("asset_id", asset_id)
    //          );
    
+   update_spending_limit(*itr);
    modify(*itr, [limit, reset_spent](account_balance_object& b) {
       b.limit = limit;
       if (reset_spent)
@@ -266,6 +271,67 @@ void database::adjust_balance_limit(const account_object& account, asset_id_type
 
 } FC_CAPTURE_AND_RETHROW( (account)(limit) ) }
 
+optional<share_type> database::get_missed_spending_limit(const account_balance_object& balance_obj) const
+{
+   const auto& dgpo = get_dynamic_global_properties();
+   if ( balance_obj.limit_epoch == dgpo.spend_limit_epoch || balance_obj.asset_type != get_dascoin_asset_id() )
+      return {};
+
+   // The reset used the price it stored as the daily price, and the max license can only change through
+   // issue_license, which updates the limit itself:
+   auto limit = get_dascoin_limit(balance_obj.owner(*this), dgpo.last_daily_dascoin_price);
+   if ( !limit.valid() || *limit <= 0 )
+      return {};
+   return limit;
+}
+
+share_type database::get_spending_limit(const account_balance_object& balance_obj) const
+{
+   const auto limit = get_missed_spending_limit(balance_obj);
+   return limit.valid() ? *limit : balance_obj.limit;
+}
+
+share_type database::get_spent_amount(const account_balance_object& balance_obj) const
+{
+   return get_missed_spending_limit(balance_obj).valid() ? share_type(0) : balance_obj.spent;
+}
+
+fc::variant database::object_to_variant(const object& obj) const
+{
+   if ( obj.id.space() == implementation_ids && obj.id.type() == impl_account_balance_object_type )
+   {
+      const auto& balance_obj = static_cast<const account_balance_object&>(obj);
+      const auto epoch = get_dynamic_global_properties().spend_limit_epoch;
+      if ( balance_obj.limit_epoch != epoch && balance_obj.asset_type == get_dascoin_asset_id() )
+      {
+         account_balance_object current = balance_obj;
+         current.limit = get_spending_limit(balance_obj);
+         current.spent = get_spent_amount(balance_obj);
+         current.limit_epoch = epoch;
+         return current.to_variant();
+      }
+   }
+   return obj.to_variant();
+}
+
+void database::update_spending_limit(const account_balance_object& balance_obj)
+{ try {
+   const auto epoch = get_dynamic_global_properties().spend_limit_epoch;
+   if ( balance_obj.limit_epoch == epoch || balance_obj.asset_type != get_dascoin_asset_id() )
+      return;
+
+   const auto limit = get_missed_spending_limit(balance_obj);
+   modify(balance_obj, [&](account_balance_object& b) {
+      if ( limit.valid() )
+      {
+         b.limit = *limit;
+         b.spent = 0;
+      }
+      b.limit_epoch = epoch;
+   });
+
+} FC_CAPTURE_AND_RETHROW( (balance_obj) ) }
+
 void database::adjust_cycle_balance(account_id_type account, share_type delta)
 { try {
 
@@ -293,10 +359,9 @@ void database::adjust_cycle_balance(account_id_type account, share_type delta)
 
 optional<uint8_t> database::get_account_pi_level(const account_id_type account) const
 { try {
-   auto& index = get_index_type<account_index>().indices().get<by_id>();
-   auto itr = index.find(account);
-   if (itr != index.end())
-      return {itr->pi_level};
+   const account_object* acc = find(account);
+   if (acc != nullptr)
+      return {acc->pi_level};
    return {};
 } FC_CAPTURE_AND_RETHROW( (account) ) }
 
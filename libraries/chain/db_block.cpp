@@ -38,6 +38,10 @@
 
 #include <fc/smart_ref_impl.hpp>
 
+#include <future>
+#include <system_error>
+#include <thread>
+
 namespace graphene { namespace chain {
 
 bool database::is_known_block( const block_id_type& id )const
@@ -87,27 +91,11 @@ optional<signed_block_with_virtual_operations> database::fetch_block_with_virtua
    else
       ret = _block_id_to_block.fetch_by_number(block_num);
 
-   signed_block_with_virtual_operations ret_v(*ret);
-
-   const auto& hist_idx = get_index_type<operation_history_index>();
-   const auto& by_blnum_idx = hist_idx.indices().get<by_blnum>();
-   auto itr = by_blnum_idx.lower_bound( block_num );
-   auto end = by_blnum_idx.upper_bound( block_num );
-
-   while ( itr != end )
-   {
-      int jk = itr->op.which();
-      for(auto vop_id : virtual_op_id_vec)
-      {
-
-         if( jk == vop_id)
-         {
-            ret_v.virtual_operations.push_back(itr->op);
-         }
-      }
-      itr++;
-   }
+   if( !ret.valid() )
+      return optional<signed_block_with_virtual_operations>();
 
+   signed_block_with_virtual_operations ret_v(*ret);
+   ret_v.virtual_operations = _virtual_op_db.fetch( block_num, virtual_op_id_vec );
    return ret_v;
 }
 
@@ -153,6 +141,9 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
       [&]()
       {
          result = _push_block(new_block);
+         save_periodic_snapshot();
+         flush_periodically();
+         _periodic_save_lib = get_dynamic_global_properties().last_irreversible_block_num;
       });
    });
    return result;
@@ -265,25 +256,69 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
    if( !_pending_tx_session.valid() )
       _pending_tx_session = _undo_db.start_undo_session();
 
-   // Create a temporary undo session as a child of _pending_tx_session.
-   // The temporary session will be discarded by the destructor if
-   // _apply_transaction fails.  If we make it to merge(), we
-   // apply the changes.
+   // Take a savepoint in _pending_tx_session.
+   // The changes made after it will be rolled back by the destructor if
+   // _apply_transaction fails.  If we make it to commit(), they simply
+   // stay in the pending block session.
 
-   auto temp_session = _undo_db.start_undo_session();
+   auto temp_savepoint = _undo_db.start_savepoint();
    auto processed_trx = _apply_transaction( trx );
    _pending_tx.push_back(processed_trx);
 
    // notify_changed_objects();
 
-   // The transaction applied successfully. Merge its changes into the pending block session.
-   temp_session.merge();
+   // The transaction applied successfully, its changes are already part of the pending block session.
+   temp_savepoint.commit();
 
    // notify anyone listening to pending transactions
    on_pending_transaction( trx );
    return processed_trx;
 }
 
+void database::precompute_signature_keys( const vector<const signed_transaction*>& trxs )const
+{
+   // below this, starting the workers costs more than recovering the keys in place
+   static const size_t min_parallel_transactions = 4;
+   if( trxs.size() < min_parallel_transactions )
+      return;
+
+   const chain_id_type& chain_id = get_chain_id();
+   const size_t workers = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), trxs.size() );
+   const size_t chunk_size = ( trxs.size() + workers - 1 ) / workers;
+
+   vector< std::future<void> > recovered;
+   recovered.reserve( workers );
+   for( size_t begin = 0; begin < trxs.size(); begin += chunk_size )
+   {
+      const size_t end = std::min( begin + chunk_size, trxs.size() );
+      auto recover = [&trxs, &chain_id, begin, end]()
+      {
+         for( size_t i = begin; i < end; ++i )
+         {
+            try
+            {
+               trxs[i]->get_signature_keys( chain_id );
+            }
+            catch( const fc::exception& ) {}
+         }
+      };
+      try
+      {
+         recovered.push_back( std::async( std::launch::async, recover ) );
+      }
+      catch( const std::system_error& e )
+      {
+         // This runs in the destructor of pending_transactions_restorer, it must not throw. Without a thread the
+         // keys are recovered here, as they would be when the transactions are applied.
+         wlog( "Recovering signature keys on the chain thread: ${e}", ("e", e.what()) );
+         recover();
+      }
+   }
+
+   for( auto& r : recovered )
+      r.wait();
+}
+
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
    auto session = _undo_db.start_undo_session();
@@ -395,9 +430,9 @@ signed_block database::_generate_block(
 
       try
       {
-         auto temp_session = _undo_db.start_undo_session();
+         auto temp_savepoint = _undo_db.start_savepoint();
          processed_transaction ptx = _apply_transaction( tx );
-         temp_session.merge();
+         temp_savepoint.commit();
 
          // We have to recompute pack_size(ptx) because it may be different
          // than pack_size(tx) (i.e. if one or more results increased
@@ -457,6 +492,7 @@ void database::pop_block()
 
    _fork_db.pop_block();
    pop_undo();
+   snapshots().rebuild();
 
    _popped_tx.insert( _popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end() );
 
@@ -519,24 +555,12 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
 void database::applied_ops_to_virtual_ops( )
 {
-   for(auto& ooho : _applied_ops)
+   for( const auto& ooho : _applied_ops )
    {
-      if(ooho.valid())
-      {
-         operation_history_object& oho = *ooho;
-         if( operation_type_limits::is_virtual_operation(oho.op) )
-         {
-            vector<optional< operation_history_object > >::iterator it = std::find_if(_virtual_ops.begin(),_virtual_ops.end(),
-                  [&oho](optional<operation_history_object > const& e){
-                     return e->virtual_op == oho.virtual_op;
-            });
-
-            if(it == _virtual_ops.end())
-            {
-               _virtual_ops.push_back(ooho);
-            }
-         }
-      }
+      // collect every virtual_op number once until the collection is cleared
+      if( ooho.valid() && operation_type_limits::is_virtual_operation( ooho->op )
+          && _virtual_op_numbers.insert( ooho->virtual_op ).second )
+         _virtual_ops.push_back( ooho );
    }
 }
 
@@ -544,6 +568,7 @@ vector<optional< operation_history_object > > database::get_virtual_ops_and_clea
 {
    vector<optional< operation_history_object > > ret;
    std::swap(ret, _virtual_ops);
+   _virtual_op_numbers.clear();
    return std::move(ret);
 }
 
@@ -554,7 +579,16 @@ void database::_apply_block( const signed_block& next_block )
    applied_ops_to_virtual_ops();
    _applied_ops.clear();
 
-   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
+   const auto precomputed = precompute_transactions( next_block.transactions );
+   if( !(skip & skip_merkle_check) )
+   {
+      vector<digest_type> merkle_digests;
+      merkle_digests.reserve( precomputed.size() );
+      for( const auto& p : precomputed )
+         merkle_digests.push_back( p.merkle_digest );
+      const auto merkle_root = signed_block::calculate_merkle_root( std::move( merkle_digests ) );
+      FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",next_block.id()) );
+   }
 
    const witness_object& signing_witness = validate_block_header(skip, next_block);
    const auto& global_props = get_global_properties();
@@ -564,7 +598,7 @@ void database::_apply_block( const signed_block& next_block )
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
 
-   for( const auto& trx : next_block.transactions )
+   for( size_t i = 0; i < next_block.transactions.size(); ++i )
    {
       /* We do not need to push the undo state for each transaction
        * because they either all apply and are valid or the
@@ -572,7 +606,10 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      apply_transaction( trx, skip | skip_transaction_signatures );
+      detail::with_skip_flags( *this, skip | skip_transaction_signatures, [&]()
+      {
+         _apply_transaction( next_block.transactions[i], &precomputed[i] );
+      });
       ++_current_trx_in_block;
    }
 
@@ -614,6 +651,10 @@ void database::_apply_block( const signed_block& next_block )
    if( !_node_property_object.debug_updates.empty() )
       apply_debug_updates();
 
+   snapshots().rebuild();
+
+   _virtual_op_db.store( next_block_num, _applied_ops );
+
    // notify observers that the block has been applied
    applied_block( next_block ); //emit
    _applied_ops.clear();
@@ -632,16 +673,74 @@ processed_transaction database::apply_transaction(const signed_transaction& trx,
    return result;
 }
 
-processed_transaction database::_apply_transaction(const signed_transaction& trx)
+vector<database::precomputed_transaction> database::precompute_transactions( const vector<processed_transaction>& trxs )const
+{
+   vector<precomputed_transaction> result( trxs.size() );
+   auto precompute = [&trxs, &result]( size_t begin, size_t end )
+   {
+      for( size_t i = begin; i < end; ++i )
+      {
+         result[i].merkle_digest = trxs[i].merkle_digest();
+         result[i].id = trxs[i].id();
+         try
+         {
+            trxs[i].validate();
+         }
+         catch( ... )
+         {
+            result[i].validate_error = std::current_exception();
+         }
+      }
+   };
+
+   // below this, starting the workers costs more than hashing the transactions in place
+   static const size_t min_parallel_transactions = 16;
+   if( trxs.size() < min_parallel_transactions )
+   {
+      precompute( 0, trxs.size() );
+      return result;
+   }
+
+   const size_t workers = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), trxs.size() );
+   const size_t chunk_size = ( trxs.size() + workers - 1 ) / workers;
+
+   vector< std::future<void> > precomputed;
+   precomputed.reserve( workers );
+   for( size_t begin = 0; begin < trxs.size(); begin += chunk_size )
+   {
+      const size_t end = std::min( begin + chunk_size, trxs.size() );
+      try
+      {
+         precomputed.push_back( std::async( std::launch::async, precompute, begin, end ) );
+      }
+      catch( const std::system_error& e )
+      {
+         wlog( "Precomputing transactions on the chain thread: ${e}", ("e", e.what()) );
+         precompute( begin, end );
+      }
+   }
+
+   for( auto& p : precomputed )
+      p.get();
+   return result;
+}
+
+processed_transaction database::_apply_transaction( const signed_transaction& trx,
+                                                    const precomputed_transaction* precomputed )
 { try {
    uint32_t skip = get_node_properties().skip_flags;
 
-   if( true || !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
+   if( precomputed != nullptr )
+   {
+      if( precomputed->validate_error )
+         std::rethrow_exception( precomputed->validate_error );
+   }
+   else if( true || !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
       trx.validate();
 
    auto& trx_idx = get_mutable_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
-   auto trx_id = trx.id();
+   auto trx_id = precomputed != nullptr ? precomputed->id : trx.id();
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end() );
    transaction_evaluation_state eval_state(this);
@@ -309,7 +309,8 @@ void database::initialize_indexes()
 
    add_index< primary_index<committee_member_index> >();
    add_index< primary_index<witness_index> >();
-   add_index< primary_index<limit_order_index > >();
+   auto limit_order_idx = add_index< primary_index<limit_order_index > >();
+   limit_order_idx->add_secondary_index<limit_order_price_level_index>();
    add_index< primary_index<call_order_index > >();
 
    auto prop_index = add_index< primary_index<proposal_index > >();
@@ -323,7 +324,9 @@ void database::initialize_indexes()
 
    //Implementation object indexes
    add_index< primary_index<transaction_index                             > >();
-   add_index< primary_index<account_balance_index                         > >();
+   auto balance_idx = add_index< primary_index<account_balance_index      > >();
+   auto holder_idx = balance_idx->add_secondary_index<dasc_holder_index>( *this );
+   acnt_index->add_secondary_index<dasc_holder_account_index>( *holder_idx );
    add_index< primary_index<asset_bitasset_data_index                     > >();
    add_index< primary_index<simple_index<global_property_object          >> >();
    add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
@@ -344,7 +347,9 @@ void database::initialize_indexes()
    add_index<primary_index<issue_asset_request_index>>();
    add_index<primary_index<wire_out_holder_index>>();
    add_index<primary_index<reward_queue_index>>();
-   add_index<primary_index<license_information_index>>();
+   auto license_info_idx = add_index<primary_index<license_information_index>>();
+   license_info_idx->add_secondary_index<license_total_cycles_index>( *this );
+   license_info_idx->add_secondary_index<upgradeable_license_index>();
    add_index<primary_index<issued_asset_record_index>>();
    add_index<primary_index<frequency_history_record_index>>();
    add_index<primary_index<witness_delegate_data_index > >();
@@ -27,6 +27,10 @@
 #include <fc/smart_ref_impl.hpp>
 #include <fc/uint128.hpp>
 
+#include <future>
+#include <system_error>
+#include <thread>
+
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/fba_accumulator_id.hpp>
 #include <graphene/chain/hardfork.hpp>
@@ -688,7 +692,7 @@ void create_buyback_orders( database& db )
 
 void deprecate_annual_members( database& db )
 {
-   const auto& account_idx = db.get_index_type<account_index>().indices().get<by_id>();
+   const auto& account_idx = db.get_index_type<account_index>();
    fc::time_point_sec now = db.head_block_time();
    for( const account_object& acct : account_idx )
    {
@@ -812,19 +816,6 @@ void database::perform_upgrades(const account_object& account, const upgrade_eve
 
 void database::perform_upgrades()
 {
-   class perform_upgrades_helper
-   {
-   public:
-     explicit perform_upgrades_helper(database& d, const upgrade_event_object& upgrade)
-         : d(d), upgrade(upgrade) {}
-
-     void operator()(const account_object& a) { d.perform_upgrades(a, upgrade); }
-
-   private:
-     database& d;
-     const upgrade_event_object& upgrade;
-   };
-
    // Helper lambda which returns true if upgrade should be executed:
    const auto should_execute_upgrade_event = [this](const upgrade_event_object& upgrade) -> bool {
      // If executed already, do not execute:
@@ -844,6 +835,8 @@ void database::perform_upgrades()
    };
 
    optional<upgrade_event_object> last_upgrade{};
+   const auto& lidx = dynamic_cast<const primary_index<license_information_index>&>(get_index_type<license_information_index>());
+   const auto& upgradeable = lidx.get_secondary_index<upgradeable_license_index>();
    const auto& idx = get_index_type<upgrade_event_index>().indices().get<by_id>();
    for ( auto it = idx.cbegin(); it != idx.cend(); ++it )
    {
@@ -855,11 +848,31 @@ void database::perform_upgrades()
       });
 
       last_upgrade = *it;
-      perform_upgrades_helper upgrades_helper(*this, *it);
-      perform_helpers<account_index, by_name>(std::tie(upgrades_helper));
+
+      // Only accounts with a license record the upgrade can still apply to are visited, any other account would be
+      // left unchanged. They are upgraded in the order of their names, like when all accounts were walked, because
+      // upgrades may push to the reward queue:
+      const auto& cutoff_time = it->cutoff_time.valid() ? *(it->cutoff_time) : it->execution_time;
+      vector<const account_object*> accounts;
+      for ( const auto& lio_id : upgradeable.activated_before(cutoff_time) )
+      {
+         const auto& account = lio_id(*this).account(*this);
+         if ( account.license_information.valid() && *account.license_information == lio_id )
+            accounts.push_back(&account);
+      }
+      std::sort(accounts.begin(), accounts.end(), [](const account_object* a, const account_object* b) {
+         return a->name < b->name;
+      });
+      for ( const account_object* account : accounts )
+         perform_upgrades(*account, *it);
    }
 }
 
+void database::set_min_parallel_vote_tally( size_t accounts )
+{
+   _min_parallel_vote_tally = accounts;
+}
+
 void database::perform_chain_maintenance(const signed_block& next_block, const global_property_object& global_props)
 {
    const auto& gpo = get_global_properties();
@@ -868,19 +881,22 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    distribute_fba_balances(*this);
    create_buyback_orders(*this);
 
-   struct vote_tally_helper
+   // Sums up the voting stake per vote id and the histograms of the witness and committee counts voted for:
+   struct vote_tally
    {
-      database& d;
+      const database& d;
       const global_property_object& props;
-
-      vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
-      {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._total_voting_stake = 0;
-      }
+      vector<uint64_t> votes;
+      vector<uint64_t> witness_count_histogram;
+      vector<uint64_t> committee_count_histogram;
+      uint64_t total_voting_stake = 0;
+
+      vote_tally(const database& d, const global_property_object& gpo)
+         : d(d), props(gpo),
+           votes(props.next_available_vote_id),
+           witness_count_histogram(props.parameters.maximum_witness_count / 2 + 1),
+           committee_count_histogram(props.parameters.maximum_committee_count / 2 + 1)
+      {}
 
       void operator()(const account_object& stake_account) {
          if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
@@ -902,37 +918,48 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
             {
                uint32_t offset = id.instance();
                // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
+               if( offset < votes.size() )
+                  votes[offset] += voting_stake;
             }
 
             if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
+                                          witness_count_histogram.size() - 1);
                // votes for a number greater than maximum_witness_count
                // are turned into votes for maximum_witness_count.
                //
                // in particular, this takes care of the case where a
                // member was voting for a high number, then the
                // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
+               witness_count_histogram[offset] += voting_stake;
             }
             if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
+                                          committee_count_histogram.size() - 1);
                // votes for a number greater than maximum_committee_count
                // are turned into votes for maximum_committee_count.
                //
                // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
+               committee_count_histogram[offset] += voting_stake;
             }
 
-            d._total_voting_stake += voting_stake;
+            total_voting_stake += voting_stake;
          }
       }
-   } tally_helper(*this, gpo);
+
+      void merge(const vote_tally& other)
+      {
+         for( size_t i = 0; i < votes.size(); ++i )
+            votes[i] += other.votes[i];
+         for( size_t i = 0; i < witness_count_histogram.size(); ++i )
+            witness_count_histogram[i] += other.witness_count_histogram[i];
+         for( size_t i = 0; i < committee_count_histogram.size(); ++i )
+            committee_count_histogram[i] += other.committee_count_histogram[i];
+         total_voting_stake += other.total_voting_stake;
+      }
+   } tally(*this, gpo);
 
    struct process_fees_helper
    {
@@ -945,7 +972,65 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    } fee_helper(*this, gpo);
 
-   perform_helpers<account_index, by_name>(std::tie(tally_helper, fee_helper));
+   // Paying out fees deposits cashback to other accounts and changes their voting stake, so while any fees are
+   // pending the tally has to be interleaved with the fees in the order of the account names. Otherwise processing
+   // the fees changes nothing and the tally, which only reads the state, is split over all cores.
+   bool fees_pending = false;
+   for( const account_statistics_object& s : get_index_type<simple_index<account_statistics_object>>() )
+   {
+      if( s.pending_fees > 0 || s.pending_vested_fees > 0 )
+      {
+         fees_pending = true;
+         break;
+      }
+   }
+
+   if( fees_pending )
+      perform_helpers<account_index, by_name>(std::tie(tally, fee_helper));
+   else
+   {
+      vector<const account_object*> accounts;
+      const auto& account_idx = get_index_type<account_index>();
+      accounts.reserve(account_idx.size());
+      for( const account_object& a : account_idx )
+         accounts.push_back(&a);
+
+      const size_t workers = accounts.size() < _min_parallel_vote_tally ? 1 :
+                             std::max( 1u, std::thread::hardware_concurrency() );
+      const size_t chunk_size = ( accounts.size() + workers - 1 ) / workers;
+
+      vector<vote_tally> partial_tallies;
+      partial_tallies.reserve(workers);
+      for( size_t i = 1; i < workers; ++i )
+         partial_tallies.emplace_back(*this, gpo);
+
+      auto tally_range = [&accounts]( vote_tally& t, size_t begin, size_t end ) {
+         for( size_t i = begin; i < end; ++i )
+            t(*accounts[i]);
+      };
+      vector< std::future<void> > tallied;
+      for( size_t i = 1; i < workers; ++i )
+      {
+         const size_t begin = std::min( i * chunk_size, accounts.size() );
+         const size_t end = std::min( begin + chunk_size, accounts.size() );
+         try { tallied.push_back( std::async( std::launch::async, tally_range, std::ref(partial_tallies[i - 1]), begin, end ) ); }
+         catch( const std::system_error& e )
+         {
+            wlog( "Tallying votes on the chain thread: ${e}", ("e", e.what()) );
+            tally_range( partial_tallies[i - 1], begin, end );
+         }
+      }
+      tally_range( tally, 0, std::min( chunk_size, accounts.size() ) );
+      for( auto& t : tallied )
+         t.get();
+      for( const auto& t : partial_tallies )
+         tally.merge(t);
+   }
+
+   _vote_tally_buffer = std::move(tally.votes);
+   _witness_count_histogram_buffer = std::move(tally.witness_count_histogram);
+   _committee_count_histogram_buffer = std::move(tally.committee_count_histogram);
+   _total_voting_stake = tally.total_voting_stake;
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
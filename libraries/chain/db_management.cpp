@@ -28,13 +28,143 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <memory>
 
 namespace graphene { namespace chain {
 
+/**
+ * Describes a state snapshot written by database::save_snapshot(), stored next to its object_database directory.
+ */
+struct snapshot_manifest
+{
+   static const uint32_t current_format = 1;
+
+   uint32_t           format = current_format;
+   std::string        db_version;
+   uint32_t           head_block_num = 0;
+   block_id_type      head_block_id;
+   fc::time_point_sec head_block_time;
+   fc::sha256         checksum;
+};
+
+} }
+
+FC_REFLECT( graphene::chain::snapshot_manifest,
+            (format)(db_version)(head_block_num)(head_block_id)(head_block_time)(checksum) )
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /// Number of periodic snapshots kept in the snapshot directory
+   const size_t snapshots_to_keep = 2;
+
+   void write_db_version( const fc::path& data_dir, const std::string& db_version )
+   {
+      std::ofstream version_file( (data_dir / "db_version").generic_string().c_str(),
+                                  std::ios::out | std::ios::binary | std::ios::trunc );
+      version_file.write( db_version.c_str(), db_version.size() );
+      version_file.close();
+   }
+
+   /// Lists the files below dir in a stable order, so that the checksum does not depend on the file system
+   vector<fc::path> list_files( const fc::path& dir )
+   {
+      vector<fc::path> files;
+      for( fc::recursive_directory_iterator itr( dir ); itr != fc::recursive_directory_iterator(); ++itr )
+         if( fc::is_regular_file( *itr ) )
+            files.push_back( *itr );
+      std::sort( files.begin(), files.end(), []( const fc::path& a, const fc::path& b ) {
+         return a.generic_string() < b.generic_string();
+      });
+      return files;
+   }
+
+   fc::sha256 checksum_snapshot( const fc::path& object_database_dir )
+   {
+      fc::sha256::encoder enc;
+      vector<char> buffer( 1024 * 1024 );
+      for( const fc::path& file : list_files( object_database_dir ) )
+      {
+         const std::string name = file.parent_path().filename().generic_string() + "/" + file.filename().generic_string();
+         fc::raw::pack( enc, name );
+         std::ifstream in( file.generic_string().c_str(), std::ios::in | std::ios::binary );
+         FC_ASSERT( in, "Unable to read snapshot file ${f}", ("f", file) );
+         while( in )
+         {
+            in.read( buffer.data(), buffer.size() );
+            enc.write( buffer.data(), in.gcount() );
+         }
+      }
+      return enc.result();
+   }
+
+   /** @return the manifest of a snapshot of the state of the last irreversible block, without its checksum */
+   snapshot_manifest irreversible_manifest( const database& db, const std::string& db_version )
+   {
+      const uint32_t last_irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+      FC_ASSERT( last_irreversible > 0, "No block is irreversible yet" );
+      snapshot_manifest manifest;
+      manifest.db_version      = db_version;
+      manifest.head_block_num  = last_irreversible;
+      manifest.head_block_id   = db.get_block_id_for_num( last_irreversible );
+      manifest.head_block_time = db.fetch_block_by_number( last_irreversible )->timestamp;
+      return manifest;
+   }
+
+   /** Writes the packed indexes with their manifest to snapshot_dir, which only appears once it is complete */
+   void write_snapshot( const object_database::packed_indexes& indexes, snapshot_manifest manifest,
+                        const fc::path& snapshot_dir )
+   {
+      ilog( "Writing state snapshot at block ${n} to ${d}", ("n", manifest.head_block_num)("d", snapshot_dir) );
+      const fc::path tmp_dir = fc::path( snapshot_dir.generic_string() + ".tmp" );
+      fc::remove_all( tmp_dir );
+      object_database::write_indexes( indexes, tmp_dir / "object_database" );
+
+      manifest.checksum = checksum_snapshot( tmp_dir / "object_database" );
+      fc::json::save_to_file( manifest, tmp_dir / "manifest.json" );
+
+      // the snapshot only becomes visible under its final name once it is complete
+      fc::remove_all( snapshot_dir );
+      fc::rename( tmp_dir, snapshot_dir );
+   }
+
+   /** Removes all but the most recent periodic snapshots from snapshot_dir */
+   void prune_snapshots( const fc::path& snapshot_dir )
+   {
+      vector<uint32_t> saved;
+      for( fc::directory_iterator itr( snapshot_dir ); itr != fc::directory_iterator(); ++itr )
+      {
+         const std::string name = (*itr).filename().generic_string();
+         if( fc::is_directory( *itr ) && !name.empty() && std::all_of( name.begin(), name.end(), ::isdigit ) )
+            saved.push_back( std::stoul( name ) );
+      }
+      std::sort( saved.begin(), saved.end() );
+      for( size_t i = 0; i + snapshots_to_keep < saved.size(); ++i )
+         fc::remove_all( snapshot_dir / fc::to_string( saved[i] ) );
+   }
+
+   void copy_directory( const fc::path& from, const fc::path& to )
+   {
+      const size_t prefix = from.generic_string().size();
+      fc::create_directories( to );
+      for( const fc::path& file : list_files( from ) )
+      {
+         const fc::path target = to / file.generic_string().substr( prefix + 1 );
+         fc::create_directories( target.parent_path() );
+         fc::copy( file, target );
+      }
+   }
+}
+
 database::database()
 {
    initialize_indexes();
@@ -77,6 +207,7 @@ void database::reindex(fc::path data_dir)
       if( i == flush_point )
       {
          ilog( "Writing database to disk at block ${i}", ("i",i) );
+         flush_stores();
          flush();
          ilog( "Done" );
       }
@@ -154,18 +285,18 @@ void database::open(
       if( wipe_object_db ) {
           ilog("Wiping object_database due to missing or wrong version");
           object_database::wipe( data_dir );
-          std::ofstream version_file( (data_dir / "db_version").generic_string().c_str(),
-                                      std::ios::out | std::ios::binary | std::ios::trunc );
-          version_file.write( db_version.c_str(), db_version.size() );
-          version_file.close();
+          write_db_version( data_dir, db_version );
       }
+      _db_version = db_version;
 
       object_database::open(data_dir);
 
       _block_id_to_block.open(data_dir / "database" / "block_num_to_block");
+      _virtual_op_db.open(data_dir / "database" / "virtual_ops");
 
       if( !find(global_property_id_type()) )
          init_genesis(genesis_loader());
+      _periodic_save_lib = get_dynamic_global_properties().last_irreversible_block_num;
 
       fc::optional<block_id_type> last_block = _block_id_to_block.last_id();
       if( last_block.valid() )
@@ -179,8 +310,149 @@ void database::open(
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir) )
 }
 
+void database::save_snapshot( const fc::path& snapshot_dir )
+{ try {
+   FC_ASSERT( can_pack_irreversible_state(), "The undo history does not reach back to the last irreversible block" );
+   flush_stores();
+   const uint32_t last_irreversible = get_dynamic_global_properties().last_irreversible_block_num;
+   write_snapshot( pack_indexes( head_block_num() - last_irreversible ), irreversible_manifest( *this, _db_version ),
+                   snapshot_dir );
+} FC_CAPTURE_AND_RETHROW( (snapshot_dir) ) }
+
+void database::load_snapshot( const fc::path& snapshot_dir, const fc::path& data_dir, const std::string& db_version )
+{ try {
+   const auto manifest = fc::json::from_file( snapshot_dir / "manifest.json" ).as<snapshot_manifest>();
+   FC_ASSERT( manifest.format == snapshot_manifest::current_format, "Unsupported snapshot format",
+              ("format", manifest.format) );
+   FC_ASSERT( manifest.db_version == db_version, "Snapshot was written by an incompatible database version",
+              ("snapshot", manifest.db_version)("expected", db_version) );
+   FC_ASSERT( checksum_snapshot( snapshot_dir / "object_database" ) == manifest.checksum,
+              "Snapshot checksum does not match, the snapshot is corrupt" );
+
+   // The blocks following the snapshot are replayed from the block log, so it must contain the head block.
+   block_database blocks;
+   blocks.open( data_dir / "database" / "block_num_to_block" );
+   optional<block_id_type> last_id = blocks.last_id();
+   FC_ASSERT( last_id.valid() && block_header::num_from_id( *last_id ) >= manifest.head_block_num,
+              "The block log does not reach the head block of the snapshot",
+              ("head_block_num", manifest.head_block_num)("last_id", last_id) );
+   FC_ASSERT( manifest.head_block_num == 0 || blocks.fetch_block_id( manifest.head_block_num ) == manifest.head_block_id,
+              "The head block of the snapshot is not part of the block log",
+              ("head_block_id", manifest.head_block_id) );
+   blocks.close();
+
+   ilog( "Loading state snapshot of block ${n} from ${d}", ("n", manifest.head_block_num)("d", snapshot_dir) );
+   object_database::wipe( data_dir );
+   copy_directory( snapshot_dir / "object_database", data_dir / "object_database" );
+   write_db_version( data_dir, db_version );
+} FC_CAPTURE_AND_RETHROW( (snapshot_dir)(data_dir) ) }
+
+void database::set_snapshot_interval( const fc::path& snapshot_dir, uint32_t interval )
+{
+   _snapshot_dir = snapshot_dir;
+   _snapshot_interval = interval;
+}
+
+bool database::irreversible_block_passed( uint32_t interval )const
+{
+   return interval != 0 &&
+          get_dynamic_global_properties().last_irreversible_block_num / interval != _periodic_save_lib / interval;
+}
+
+bool database::can_pack_irreversible_state()const
+{
+   return _undo_db.size() >= head_block_num() - get_dynamic_global_properties().last_irreversible_block_num;
+}
+
+void database::save_periodic_snapshot()
+{
+   if( !irreversible_block_passed( _snapshot_interval ) )
+      return;
+
+   const uint32_t last_irreversible = get_dynamic_global_properties().last_irreversible_block_num;
+   if( _snapshot_writer.valid() && _snapshot_writer.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+   {
+      wlog( "Skipping the state snapshot at block ${n}, the previous one is still being written",
+            ("n", last_irreversible) );
+      return;
+   }
+   if( !can_pack_irreversible_state() )
+   {
+      wlog( "Skipping the state snapshot at block ${n}, the undo history does not reach back to it",
+            ("n", last_irreversible) );
+      return;
+   }
+
+   try
+   {
+      // The blocks after the last irreversible one may still be undone, so their changes are left out. Only the
+      // packing has to happen here, the files are written, checksummed and pruned in the background.
+      flush_stores();
+      auto indexes = std::make_shared<packed_indexes>( pack_indexes( head_block_num() - last_irreversible ) );
+      const snapshot_manifest manifest = irreversible_manifest( *this, _db_version );
+
+      const fc::path snapshot_dir = _snapshot_dir;
+      _snapshot_writer = std::async( std::launch::async, [indexes, manifest, snapshot_dir]() {
+         try
+         {
+            write_snapshot( *indexes, manifest, snapshot_dir / fc::to_string( manifest.head_block_num ) );
+            prune_snapshots( snapshot_dir );
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Failed to write state snapshot: ${e}", ("e", e.to_detail_string()) );
+         }
+      } );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Failed to write state snapshot: ${e}", ("e", e.to_detail_string()) );
+   }
+}
+
+void database::set_flush_interval( uint32_t interval )
+{
+   _flush_interval = interval;
+}
+
+void database::flush_periodically()
+{
+   if( !irreversible_block_passed( _flush_interval ) )
+      return;
+
+   try
+   {
+      // As with the snapshots, the changes of the reversible blocks are left out. A node restarting from the
+      // flushed state replays the block log from the last irreversible block, which no fork can replace.
+      const uint32_t last_irreversible = get_dynamic_global_properties().last_irreversible_block_num;
+      if( !can_pack_irreversible_state() )
+      {
+         // after a restart the undo history only grows back to the last irreversible block with new blocks
+         wlog( "Skipping the flush at block ${n}, the undo history does not reach back to it", ("n", last_irreversible) );
+         return;
+      }
+      flush_stores();
+      if( !flush_async( head_block_num() - last_irreversible ) )
+         wlog( "Skipping the flush at block ${n}, the previous one is still being written", ("n", last_irreversible) );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Failed to flush the object database: ${e}", ("e", e.to_detail_string()) );
+   }
+}
+
+void database::flush_stores()
+{
+   _block_id_to_block.flush();
+   _virtual_op_db.flush();
+   flushing();
+}
+
 void database::close(bool rewind)
 {
+   if( _snapshot_writer.valid() )
+      _snapshot_writer.wait();
+
    // TODO:  Save pending tx's on close()
    clear_pending();
 
@@ -211,11 +483,13 @@ void database::close(bool rewind)
    // DB state (issue #336).
    clear_pending();
 
+   flush_stores();
    object_database::flush();
    object_database::close();
 
    if( _block_id_to_block.is_open() )
       _block_id_to_block.close();
+   _virtual_op_db.close();
 
    _fork_db.reset();
 }
@@ -641,20 +641,20 @@ asset database::pay_market_fees( const asset_object& recv_asset, const asset& re
 void database::get_groups_of_limit_order_prices(const asset_id_type& a, const asset_id_type& b,
                                                 flat_set<share_type>& prices, bool ascending, uint32_t max_prices) const
 {
-  const auto& limit_order_idx = get_index_type<limit_order_index>();
-  const auto& limit_price_idx = limit_order_idx.indices().get<by_price>();
-  auto limit_itr = limit_price_idx.lower_bound(price::max(a, b));
-  auto limit_end = limit_price_idx.upper_bound(price::min(a, b));
+  const auto& limit_order_idx = dynamic_cast<const primary_index<limit_order_index>&>(get_index_type<limit_order_index>());
+  const auto& levels = limit_order_idx.get_secondary_index<limit_order_price_level_index>().get_levels(a, b);
+  if (levels.empty())
+    return;
   auto& asset_a = get(a);
   auto& asset_b = get(b);
   double coefficient = asset::scaled_precision(asset_a.precision).value * 1.0 / asset::scaled_precision(asset_b.precision).value;
-  while(limit_itr != limit_end) {
-    double price = ascending ? 1 / limit_itr->sell_price.to_real() : limit_itr->sell_price.to_real();
+  // Orders at the same price round to the same group, so it is enough to visit each price level once:
+  for (const auto& level : levels) {
+    double price = ascending ? 1 / level.first.to_real() : level.first.to_real();
     auto p = round((ascending ? price * coefficient : price / coefficient) * DASCOIN_FIAT_ASSET_PRECISION);
     prices.insert(static_cast<share_type>(p));
     if (prices.size() >= max_prices)
       return;
-    ++limit_itr;
   }
 }
 
@@ -734,16 +734,25 @@ void database::notify_changed_objects()
    if ( _undo_db.enabled() )
    {
       const auto& head_undo = _undo_db.head();
+
+      // An object has several records when it was changed again after a savepoint was taken. The first one holds
+      // its value before the state, the latest one tells whether it still exists.
+      auto is_removed = [&]( const undo_record& first ) {
+         const auto kind = head_undo.records[head_undo.record_of.at(first.id)].kind;
+         return kind == undo_record::removed || kind == undo_record::created_removed;
+      };
       
       // New:
       if( !new_objects.empty() )
       {
-         vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
+         vector<object_id_type> new_ids;  new_ids.reserve(head_undo.records.size());
          flat_set<account_id_type> new_accounts_impacted;
-         for( const auto& item : head_undo.new_ids )
+         for( const auto& record : head_undo.records )
          {
-            new_ids.push_back(item);
-            auto obj = find_object(item);
+            if( record.prev != undo_record::npos || record.kind != undo_record::created || is_removed( record ) )
+               continue;
+            new_ids.push_back(record.id);
+            auto obj = find_object(record.id);
             if(obj != nullptr)
                get_relevant_accounts(obj, new_accounts_impacted);
          }
@@ -754,13 +763,15 @@ void database::notify_changed_objects()
       // Changed:
       if( !changed_objects.empty() )
       {
-         vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
+         vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.records.size());
          flat_set<account_id_type> changed_accounts_impacted;
 
-         for( const auto& item : head_undo.old_values )
+         for( const auto& record : head_undo.records )
          {
-            changed_ids.push_back(item.first);
-            get_relevant_accounts(item.second.get(), changed_accounts_impacted);
+            if( record.prev != undo_record::npos || record.kind != undo_record::modified || is_removed( record ) )
+               continue;
+            changed_ids.push_back(record.id);
+            get_relevant_accounts(record.old_value, changed_accounts_impacted);
          }
 
          changed_objects(changed_ids, changed_accounts_impacted);
@@ -769,13 +780,16 @@ void database::notify_changed_objects()
       // Removed:
       if( !removed_objects.empty() )
       {
-         vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
-         vector<const object*> removed; removed.reserve( head_undo.removed.size() );
+         vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.records.size() );
+         vector<const object*> removed; removed.reserve( head_undo.records.size() );
          flat_set<account_id_type> removed_accounts_impacted;
-         for( const auto& item : head_undo.removed )
+         for( const auto& record : head_undo.records )
          {
-            removed_ids.emplace_back( item.first );
-            auto obj = item.second.get();
+            if( record.prev != undo_record::npos || record.kind == undo_record::created
+                || record.kind == undo_record::created_removed || !is_removed( record ) )
+               continue;
+            removed_ids.emplace_back( record.id );
+            auto obj = record.old_value;
             removed.emplace_back( obj );
             get_relevant_accounts(obj, removed_accounts_impacted);
          }
@@ -26,6 +26,7 @@
 #include <graphene/chain/db_with.hpp>
 
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/daspay_object.hpp>
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/license_objects.hpp>
@@ -510,22 +511,13 @@ void database::reset_spending_limits()
 
   if ( dgpo.next_spend_limit_reset <= head_block_time() )
   {
-    // Reset spending limit for each account:
-    const auto& account_idx = get_index_type<account_index>().indices().get<by_id>();
-    for ( const auto& account : account_idx )
-    {
-      // TODO: price should be a weekly average price, not the last price at the moment of sampling.
-      auto dsc_limit = get_dascoin_limit(account, dgpo.last_dascoin_price);
-      if ( dsc_limit.valid() )
-      {
-        // Set the limit on the account balance object:
-        adjust_balance_limit(account, get_dascoin_asset_id(), *dsc_limit, true);
-      }
-    }
-
-    // Set the time of the next limit reset:
+    // Reset spending limit for each account by starting a new epoch. A balance is reset when it is next used, with
+    // the limit computed from the price stored as the daily price here, see update_spending_limit.
+    // TODO: price should be a weekly average price, not the last price at the moment of sampling.
+    // Also set the time of the next limit reset:
     modify(dgpo, [&](dynamic_global_property_object& dgpo){
       dgpo.last_daily_dascoin_price = dgpo.last_dascoin_price;
+      ++dgpo.spend_limit_epoch;
       uint32_t now_sec = head_block_time().sec_since_epoch();
       uint32_t next_interval = (now_sec / params.limit_interval_elapse_time_seconds) *
                                 params.limit_interval_elapse_time_seconds + params.limit_interval_elapse_time_seconds;
@@ -550,39 +542,60 @@ void database::mint_dascoin_rewards()
     auto to_distribute = get_global_properties().parameters.dascoin_reward_amount;
     share_type total_distributed = 0;
 
+    // First find the submissions to be paid, the last one may only be paid in part:
     const auto& queue = get_index_type<reward_queue_index>().indices().get<by_time>();
-    while ( to_distribute > 0 && !queue.empty() )
+    vector<std::pair<const reward_queue_object*, share_type>> paid;
+    for ( auto it = queue.begin(); to_distribute > 0 && it != queue.end(); ++it )
+    {
+      const auto dascoin_amount = std::min(cycles_to_dascoin(it->amount, it->frequency), to_distribute);
+      paid.emplace_back(&*it, dascoin_amount);
+      total_distributed += dascoin_amount;
+      to_distribute -= dascoin_amount;
+    }
+
+    // Emit a virtual operation for each submission, in the order of the queue:
+    flat_map<account_id_type, share_type> minted;
+    _applied_ops.reserve(_applied_ops.size() + paid.size());
+    for ( const auto& p : paid )
+    {
+      const auto& el = *p.first;
+      push_applied_operation(record_distribute_dascoin_operation(el.origin, el.license, el.account,
+                                                                 el.amount, el.frequency,
+                                                                 p.second, head_block_time()));
+      minted[el.account] += p.second;
+    }
+
+    // Issue the DasCoin once per account:
+    const auto dascoin_id = get_dascoin_asset_id();
+    for ( const auto& m : minted )
+    {
+      if ( m.second == 0 )
+        continue;
+      modify(get_balance_object(m.first, dascoin_id), [&m](account_balance_object& b) {
+        b.balance += m.second;
+      });
+    }
+    if ( total_distributed > 0 )
+      modify(dascoin_id(*this).dynamic_asset_data_id(*this), [&](asset_dynamic_data_object& data){
+        data.current_supply += total_distributed;
+      });
+
+    // Remove the paid submissions, except the last one if it was only paid in part:
+    for ( const auto& p : paid )
     {
-      const auto& el = *queue.begin();
-      auto dascoin_amount = cycles_to_dascoin(el.amount, el.frequency);
-      if ( to_distribute >= dascoin_amount )
+      const auto& el = *p.first;
+      if ( p.second == cycles_to_dascoin(el.amount, el.frequency) )
       {
-        // TODO: refactor this call?
-        issue_asset(el.account, dascoin_amount, get_dascoin_asset_id(), 0);
-        // Emit a virtual operation:
-        push_applied_operation(record_distribute_dascoin_operation(el.origin, el.license, el.account,
-                                                                   el.amount, el.frequency, 
-                                                                   dascoin_amount, head_block_time()));
         remove(el);
         last_minted_number++;
       }
       else
       {
-        dascoin_amount = to_distribute;
-        // TODO: refactor this call?
-        issue_asset(el.account, dascoin_amount, get_dascoin_asset_id(), 0);
-        // Emit a virtual operation:
-        push_applied_operation(record_distribute_dascoin_operation(el.origin, el.license, el.account,
-                                                                   el.amount, el.frequency, 
-                                                                   dascoin_amount, head_block_time()));
-        share_type cycles = dascoin_to_cycles(dascoin_amount, el.frequency);
+        share_type cycles = dascoin_to_cycles(p.second, el.frequency);
         modify(el, [cycles](reward_queue_object& rqo){
           rqo.amount -= cycles;
         });
       }
-
-      total_distributed += dascoin_amount;
-      to_distribute -= dascoin_amount;
     }
 
     modify(dgpo, [&](dynamic_global_property_object& dgpo){
@@ -710,13 +723,23 @@ void database::resolve_delayed_operations()
   if ( dgpo.next_delayed_operations_resolver_time > head_block_time() )
     return;
 
-  const auto& idx = get_index_type<delayed_operations_index>().indices().get<by_account>();
-  for (auto it = idx.cbegin(); it != idx.cend(); ++it)
+  // The earliest due entry sits at the front of by_due_time, so an interval without due operations costs nothing:
+  const auto& idx = get_index_type<delayed_operations_index>().indices().get<by_due_time>();
+  if ( !idx.empty() && idx.begin()->due_time() <= head_block_time() )
   {
-    if (it->issued_time + it->skip <= head_block_time())
+    vector<const delayed_operation_object*> due;
+    for ( auto it = idx.begin(); it != idx.end() && it->due_time() <= head_block_time(); ++it )
+      due.push_back(&*it);
+
+    // Resolve in (account, id) order, the order in which the operations have always been applied:
+    std::sort(due.begin(), due.end(), [](const delayed_operation_object* a, const delayed_operation_object* b) {
+      return std::tie(a->account, a->id) < std::tie(b->account, b->id);
+    });
+
+    for ( const auto* dop : due )
     {
-      it->op.visit(op_visitor(*this));
-      remove(*it);
+      dop->op.visit(op_visitor(*this));
+      remove(*dop);
     }
   }
 
@@ -121,6 +121,7 @@ namespace graphene { namespace chain {
 
          share_type eur_limit;  // The limit in euros for this balance.
          share_type limit;  // The limit used for transfers on this balance.
+         uint32_t limit_epoch = 0;  // The spend limit epoch the limit and spent amount were last reset in.
 
          asset get_balance() const { return asset{balance, asset_type}; }
          asset get_reserved_balance() const { return asset{reserved, asset_type}; }
@@ -448,6 +449,86 @@ namespace graphene { namespace chain {
          map< account_id_type, set<account_id_type> > referred_by;
    };
 
+   /**
+    *  @brief This secondary index of the account balances ranks the DasCoin holders by their aggregated balance.
+    *
+    *  A holder is a wallet, a custodian or a vault without parents. The total of a wallet includes the balances of
+    *  the vaults in its vault list. Every change of a DasCoin balance adjusts the totals of the holders it belongs
+    *  to, so the ranking never has to be recomputed from all accounts.
+    *
+    *  The index is built on first use and is only maintained from then on, which keeps the callbacks free while the
+    *  object database is loaded (in parallel over the indexes) or replayed.
+    */
+   class dasc_holder_index : public secondary_index
+   {
+      public:
+         dasc_holder_index( const database& db ):_db(db){}
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** called by dasc_holder_account_index */
+         void account_inserted( const account_object& a );
+         void account_removed( const account_object& a );
+         void account_about_to_modify( const account_object& before );
+         void account_modified( const account_object& after );
+
+         /** @return up to count holders with their aggregated DasCoin balance, the largest first */
+         vector< std::pair<account_id_type, share_type> > top( uint32_t count )const;
+
+      private:
+         struct by_amount_desc
+         {
+            bool operator()( const std::pair<share_type, account_id_type>& a,
+                             const std::pair<share_type, account_id_type>& b )const
+            {
+               return a.first > b.first || ( a.first == b.first && a.second < b.second );
+            }
+         };
+
+         static bool is_holder( const account_object& a );
+
+         void build()const;
+         share_type aggregated_balance( const account_object& a )const;
+         void set_total( account_id_type holder, share_type total )const;
+         void erase_total( account_id_type holder )const;
+         void adjust( account_id_type account, share_type delta )const;
+         void link_vaults( account_id_type wallet, const flat_set<account_id_type>& vaults )const;
+         void unlink_vaults( account_id_type wallet, const flat_set<account_id_type>& vaults )const;
+
+         const database&                                                   _db;
+         mutable bool                                                      _built = false;
+         /** aggregated balance of every holder */
+         mutable map< account_id_type, share_type >                        _totals;
+         mutable set< std::pair<share_type, account_id_type>, by_amount_desc > _ranking;
+         /** maps a vault to the wallets that have it in their vault list */
+         mutable map< account_id_type, flat_set<account_id_type> >         _wallets_of_vault;
+
+         share_type                                                        _before_balance;
+         bool                                                              _before_holder = false;
+         flat_set<account_id_type>                                         _before_vaults;
+   };
+
+   /**
+    *  @brief Forwards the changes of accounts to the dasc_holder_index, as they decide who is a holder and which
+    *  vaults count towards a wallet.
+    */
+   class dasc_holder_account_index : public secondary_index
+   {
+      public:
+         dasc_holder_account_index( dasc_holder_index& holders ):_holders(holders){}
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+      private:
+         dasc_holder_index& _holders;
+   };
+
    struct by_account_asset;
    struct by_asset_balance;
    /**
@@ -456,7 +537,6 @@ namespace graphene { namespace chain {
    typedef multi_index_container<
       account_balance_object,
       indexed_by<
-         ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
          ordered_unique< tag<by_account_asset>,
             composite_key<
                account_balance_object,
@@ -483,7 +563,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+   typedef dense_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
 
    struct by_name;
    typedef multi_index_container<
@@ -498,10 +578,20 @@ namespace graphene { namespace chain {
       >
    > account_multi_index_type;
 
+   /// The keys of account_index, which looks accounts up by id on its own
+   typedef multi_index_container<
+      account_object,
+      indexed_by<
+         ordered_unique< tag<by_name>,
+            member<account_object, string, &account_object::name>
+         >
+      >
+   > account_dense_multi_index_type;
+
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_object, account_multi_index_type> account_index;
+   typedef dense_index<account_object, account_dense_multi_index_type> account_index;
 
    struct by_account_id;
    typedef multi_index_container<
@@ -560,6 +650,7 @@ FC_REFLECT_DERIVED( graphene::chain::account_balance_object, (graphene::db::obje
                     (spent)
                     (eur_limit)
                     (limit)
+                    (limit_epoch)
                   )
 
 FC_REFLECT_DERIVED( graphene::chain::account_cycle_balance_object, (graphene::db::object),
@@ -22,15 +22,82 @@
  * THE SOFTWARE.
  */
 #pragma once
-#include <fstream>
+#include <atomic>
+#include <memory>
 #include <graphene/chain/protocol/block.hpp>
+#include <fc/interprocess/file_mapping.hpp>
 
 namespace graphene { namespace chain {
    class index_entry;
 
+   /**
+    *  A view of a packed block as it is stored in the block log. The bytes are
+    *  not copied, they point into the memory mapped blocks file and remain
+    *  valid until the block_database they came from is closed.
+    */
+   struct raw_block_view
+   {
+      const char*   data = nullptr;
+      uint32_t      size = 0;
+      block_id_type id;
+   };
+
+   namespace detail {
+
+   /**
+    *  @class mapped_log_file
+    *  @brief A file that is memory mapped read/write and grown in large chunks.
+    *
+    *  Growing the file never remaps the existing region in place. A new, larger
+    *  mapping is published instead and the old ones are kept alive until close(),
+    *  so a reader holding a pointer obtained through data() may keep using it
+    *  while the writer appends.
+    */
+   class mapped_log_file
+   {
+      public:
+         void     open( const fc::path& filename, uint64_t chunk_size );
+         bool     is_open()const { return _is_open; }
+         void     flush();
+         /** Unmaps the file and truncates it on disk to @ref logical_size bytes */
+         void     close( uint64_t logical_size );
+
+         /** Makes sure that at least new_size bytes are mapped, growing the file if necessary */
+         void     reserve( uint64_t new_size );
+
+         char*    data()const     { return _data.load( std::memory_order_acquire ); }
+         uint64_t capacity()const { return _capacity; }
+         uint64_t file_size()const { return _file_size; }
+
+      private:
+         void     map( uint64_t size );
+
+         fc::path                                 _filename;
+         bool                                     _is_open = false;
+         uint64_t                                 _chunk_size = 0;
+         uint64_t                                 _capacity = 0;
+         uint64_t                                 _file_size = 0;
+         std::atomic<char*>                       _data{ nullptr };
+         std::unique_ptr<fc::file_mapping>        _mapping;
+         vector< std::unique_ptr<fc::mapped_region> > _regions;
+   };
+
+   } // detail
+
+   /**
+    *  @class block_database
+    *  @brief Append only log of irreversible and reversible blocks, addressed by block number.
+    *
+    *  The database consists of two files: an index with one fixed size entry per block number
+    *  and the blocks file holding the packed blocks. Both files are memory mapped, so lookups do
+    *  not issue any system calls. There is a single writer (the chain thread) and any number of
+    *  concurrent readers; readers never take a lock.
+    */
    class block_database
    {
       public:
+         ~block_database();
+
          void open( const fc::path& dbdir );
          bool is_open()const;
          void flush();
@@ -43,12 +110,20 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /** @return the packed bytes of the block without copying or unpacking them */
+         optional<raw_block_view> fetch_raw( uint32_t block_num )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
       private:
+         bool read_index_entry( uint32_t block_num, index_entry& e )const;
+         optional<raw_block_view> fetch_raw( const index_entry& e )const;
          optional<index_entry> last_index_entry()const;
-         fc::path _index_filename;
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+
+         fc::path                      _index_filename;
+         mutable detail::mapped_log_file _block_num_to_pos;
+         mutable detail::mapped_log_file _blocks;
+         /** logical sizes of the files in bytes, published after the data they cover is written */
+         mutable std::atomic<uint64_t> _index_size{ 0 };
+         std::atomic<uint64_t>         _blocks_size{ 0 };
    };
 } }
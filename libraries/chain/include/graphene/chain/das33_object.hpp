@@ -49,6 +49,7 @@ namespace graphene { namespace chain {
     share_type collected;
     vector<price> token_prices;
     das33_project_status status;
+    flat_map<asset_id_type, share_type> total_pledged; ///< running sum of all pledges, by pledged asset
 
     das33_project_object() = default;
     explicit das33_project_object(string name, account_id_type owner, asset_id_type token, share_type min_to_collect, vector<price> ratios)
@@ -136,6 +137,7 @@ namespace graphene { namespace chain {
   using das33_pledge_holder_index = generic_index<das33_pledge_holder_object, das33_pledge_holder_multi_index_type>;
 
   struct by_project_name;
+  struct by_token;
   typedef multi_index_container<
       das33_project_object,
       indexed_by<
@@ -146,6 +148,11 @@ namespace graphene { namespace chain {
         ordered_unique<
           tag<by_project_name>,
           member<das33_project_object, string, &das33_project_object::name>
+        >,
+        // not unique, so that replaying the chain never fails on it, the evaluator rejects tokens in use
+        ordered_non_unique<
+          tag<by_token>,
+          member<das33_project_object, asset_id_type, &das33_project_object::token_id>
         >
      >
   > das33_project_multi_index_type;
@@ -175,4 +182,5 @@ FC_REFLECT_DERIVED( graphene::chain::das33_project_object, (graphene::db::object
                     (collected)
                     (token_prices)
                     (status)
+                    (total_pledged)
                   )
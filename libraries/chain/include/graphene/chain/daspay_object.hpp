@@ -90,6 +90,10 @@ namespace graphene { namespace chain {
       return op.which();
     }
 
+    fc::time_point_sec due_time() const {
+      return issued_time + skip;
+    }
+
     delayed_operation_object() = default;
     explicit delayed_operation_object(account_id_type account,
                                              operation op,
@@ -175,6 +179,7 @@ namespace graphene { namespace chain {
 
   struct by_account;
   struct by_operation;
+  struct by_due_time;
   using delayed_operations_multi_index_type = multi_index_container<
     delayed_operation_object,
     indexed_by<
@@ -195,6 +200,13 @@ namespace graphene { namespace chain {
             member< delayed_operation_object, account_id_type, &delayed_operation_object::account >,
             const_mem_fun< delayed_operation_object, int, &delayed_operation_object::which >
           >
+      >,
+      ordered_unique<
+        tag<by_due_time>,
+          composite_key< delayed_operation_object,
+            const_mem_fun< delayed_operation_object, fc::time_point_sec, &delayed_operation_object::due_time >,
+            member< object, object_id_type, &object::id >
+          >
       >
     >
   >;
@@ -28,6 +28,7 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/virtual_op_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 #include <graphene/chain/license_objects.hpp>
@@ -42,7 +43,10 @@
 
 #include <fc/log/logger.hpp>
 
+#include <exception>
+#include <future>
 #include <map>
+#include <unordered_set>
 
 namespace graphene { namespace chain {
    using graphene::db::abstract_object;
@@ -115,6 +119,50 @@ namespace graphene { namespace chain {
          void wipe(const fc::path& data_dir, bool include_blocks);
          void close(bool rewind = true);
 
+         /**
+          * @brief Write a snapshot of the state of the last irreversible block to snapshot_dir
+          *
+          * The snapshot holds every index in the format written by flush(), along with a manifest recording the
+          * database version, the last irreversible block as its head block and a checksum of the index files.
+          * The changes of the reversible blocks are left out, as a fork may still replace them.
+          */
+         void save_snapshot( const fc::path& snapshot_dir );
+
+         /**
+          * @brief Install a snapshot as the object database in data_dir
+          *
+          * Must be called before @ref database::open, which will then replay only the blocks of the block log that
+          * follow the head block of the snapshot. The snapshot is rejected if its version or checksum do not match,
+          * or if its head block is not part of the block log in data_dir.
+          */
+         void load_snapshot( const fc::path& snapshot_dir, const fc::path& data_dir, const std::string& db_version );
+
+         /**
+          * @brief Save a snapshot into a sub-directory of snapshot_dir every interval blocks
+          *
+          * A snapshot holds the state of the last irreversible block, and is taken whenever that block passes a
+          * multiple of interval; the sub-directory is named after the block. The state is packed when the block
+          * is pushed, the files are written in the background. Only the most recent snapshots are kept. An
+          * interval of 0 disables periodic snapshots.
+          */
+         void set_snapshot_interval( const fc::path& snapshot_dir, uint32_t interval );
+
+         /**
+          * @brief Flush the object database every interval blocks, so that a restart only replays the blocks since
+          *
+          * The state of the last irreversible block is flushed whenever that block passes a multiple of interval.
+          * The state is packed when the block is pushed, the files are written in the background. An interval of
+          * 0 disables periodic flushes, the database is then only flushed on close.
+          */
+         void set_flush_interval( uint32_t interval );
+
+         /**
+          * @brief Tally the votes on all cores at maintenance once there are at least this many accounts
+          *
+          * Below it, starting the worker threads costs more than tallying the accounts on the chain thread.
+          */
+         void set_min_parallel_vote_tally( size_t accounts );
+
          //////////////////// db_block.cpp ////////////////////
 
          /**
@@ -145,6 +193,13 @@ namespace graphene { namespace chain {
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const signed_transaction& trx );
 
+         /**
+          *  Recovers the signature keys of the given transactions on a set of worker threads and caches them
+          *  on the transactions, so that applying them one by one afterwards does not have to. Failures are
+          *  ignored here, they are reported again when the transaction is applied.
+          */
+         void precompute_signature_keys( const vector<const signed_transaction*>& trxs )const;
+
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
@@ -199,6 +254,13 @@ namespace graphene { namespace chain {
           */
          fc::signal<void(const signed_transaction&)>     on_pending_transaction;
 
+         /**
+          *  Emitted on the chain thread before the object database is flushed or a snapshot of it is taken. Plugins
+          *  that move data out of the object database into stores of their own flush those stores here, so that a
+          *  flushed state never lacks data that only reached their memory mapped files.
+          */
+         fc::signal<void()>                              flushing;
+
          /**
           *  Emitted After a block has been applied and committed.  The callback
           *  should not yield and should execute quickly.
@@ -387,6 +449,26 @@ namespace graphene { namespace chain {
           */
          void adjust_balance_limit(const account_object& account, asset_id_type asset_id, share_type limit, bool reset_spent = false);
 
+         /**
+          * The spending limits of DasCoin balances are reset lazily: a reset only advances the spend limit epoch, and
+          * a balance reset in an earlier epoch is brought up to date when it is used. These methods return the limit
+          * and spent amount the balance would have if all balances had been reset eagerly.
+          */
+         share_type get_spending_limit(const account_balance_object& balance_obj) const;
+         share_type get_spent_amount(const account_balance_object& balance_obj) const;
+
+         /**
+          * @return the object as the APIs report it. The stored limit and spent amount of a DasCoin balance are stale
+          * until the balance is used again, so a balance that missed a reset is reported with the values returned by
+          * get_spending_limit and get_spent_amount, and with the current epoch.
+          */
+         fc::variant object_to_variant(const object& obj) const;
+
+         /**
+          * Applies the spend limit resets the balance has missed. Must be called before changing the spent amount.
+          */
+         void update_spending_limit(const account_balance_object& balance_obj);
+
          /**
           * @brief Adjsut a particular account's cycle balance by a delta.
           * @param account ID of the account whose balance should be adjusted.
@@ -621,8 +703,23 @@ namespace graphene { namespace chain {
          processed_transaction apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          operation_result      apply_operation( transaction_evaluation_state& eval_state, const operation& op );
       private:
+         /**
+          *  The part of applying a transaction which does not depend on the state: its merkle digest, its id and
+          *  the result of validate(), which is rethrown when the transaction is applied.
+          */
+         struct precomputed_transaction
+         {
+            digest_type         merkle_digest;
+            transaction_id_type id;
+            std::exception_ptr  validate_error;
+         };
+
+         /** Precomputes the transactions of a block, spread over all cores */
+         vector<precomputed_transaction> precompute_transactions( const vector<processed_transaction>& trxs )const;
+
          void                  _apply_block( const signed_block& next_block );
-         processed_transaction _apply_transaction( const signed_transaction& trx );
+         processed_transaction _apply_transaction( const signed_transaction& trx,
+                                                   const precomputed_transaction* precomputed = nullptr );
 
          ///Steps involved in applying a new block
          ///@{
@@ -646,6 +743,8 @@ namespace graphene { namespace chain {
          void distribute_issue_requested_assets();
          void mint_dascoin_rewards();
          void reset_spending_limits();
+         /// @return the limit set by the last spend limit reset, if the balance missed it and it would have been reset
+         optional<share_type> get_missed_spending_limit(const account_balance_object& balance_obj) const;
          void daspay_clearing_start();
          void resolve_delayed_operations();
 private:
@@ -687,6 +786,24 @@ private:
          vector< processed_transaction >        _pending_tx;
          fork_database                          _fork_db;
 
+         /** @return true if the last pushed block moved the last irreversible block past a multiple of interval */
+         bool irreversible_block_passed( uint32_t interval )const;
+         /** @return true if the undo history reaches back to the state of the last irreversible block */
+         bool can_pack_irreversible_state()const;
+         void save_periodic_snapshot();
+         void flush_periodically();
+         /// Flushes the block log, the virtual operations and the stores of the plugins, before the object database
+         void flush_stores();
+
+         std::string                            _db_version;
+         fc::path                               _snapshot_dir;
+         uint32_t                               _snapshot_interval = 0;
+         uint32_t                               _flush_interval = 0;
+         /// the last irreversible block before the last pushed block
+         uint32_t                               _periodic_save_lib = 0;
+         /// writes the files of the last periodic snapshot
+         std::future<void>                      _snapshot_writer;
+
          /**
           *  Note: we can probably store blocks by block num rather than
           *  block id because after the undo window is past the block ID
@@ -697,6 +814,8 @@ private:
           *  the fork tree relatively simple.
           */
          block_database   _block_id_to_block;
+         /** the virtual operations of the applied blocks, written when a block is applied */
+         virtual_op_database _virtual_op_db;
 
          /**
           * Contains the set of ops that are in the process of being applied from
@@ -712,6 +831,8 @@ private:
           * order they occur and is cleared after account history plugin is updated
           */
          vector<optional<operation_history_object> >  _virtual_ops;
+         /** the virtual_op numbers of the operations in _virtual_ops */
+         std::unordered_set<uint16_t>                 _virtual_op_numbers;
 
          uint32_t                          _current_block_num    = 0;
          uint16_t                          _current_trx_in_block = 0;
@@ -722,6 +843,7 @@ private:
          vector<uint64_t>                  _witness_count_histogram_buffer;
          vector<uint64_t>                  _committee_count_histogram_buffer;
          uint64_t                          _total_voting_stake;
+         size_t                            _min_parallel_vote_tally = 4096;
 
          flat_map<uint32_t,block_id_type>  _checkpoints;
 
@@ -76,6 +76,14 @@ struct pending_transactions_restorer
 
    ~pending_transactions_restorer()
    {
+      vector<const signed_transaction*> to_restore;
+      to_restore.reserve( _db._popped_tx.size() + _pending_transactions.size() );
+      for( const auto& tx : _db._popped_tx )
+         to_restore.push_back( &tx );
+      for( const auto& tx : _pending_transactions )
+         to_restore.push_back( &tx );
+      _db.precompute_signature_keys( to_restore );
+
       for( const auto& tx : _db._popped_tx )
       {
          try {
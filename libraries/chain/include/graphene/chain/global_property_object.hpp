@@ -177,6 +177,12 @@ namespace graphene { namespace chain {
           */
          time_point_sec next_spend_limit_reset = fc::time_point_sec();
 
+         /**
+          * Counts the spend limit resets. The limit of a DasCoin balance is reset on its first use after the count
+          * has moved past the balance's limit_epoch, see database::update_spending_limit.
+          */
+         uint32_t spend_limit_epoch = 0;
+
          /**
           * Last dascoin trade price on the DSC:WEBEUR market.
           */
@@ -242,8 +248,10 @@ FC_REFLECT_DERIVED( graphene::chain::dynamic_global_property_object, (graphene::
                     (last_irreversible_block_num)
                     (next_dascoin_reward_time)
                     (next_spend_limit_reset)
+                    (spend_limit_epoch)
                     (is_root_authority_enabled_flag)
                     (last_dascoin_price)
+                    (last_daily_dascoin_price)
                     (fee_pool_account_id)
                   )
 
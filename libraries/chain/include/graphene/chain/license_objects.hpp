@@ -33,6 +33,8 @@
 
 namespace graphene { namespace chain {
 
+  class database;
+
   namespace detail {
 
     enum policy
@@ -145,7 +147,7 @@ namespace graphene { namespace chain {
       upgrade_type requeue_upgrade;
       upgrade_type return_upgrade;
 
-      bool is_manual_submit()
+      bool is_manual_submit() const
       {
         return (vault_license_kind == license_kind::locked_frequency || vault_license_kind == license_kind::utility);
       }
@@ -288,10 +290,6 @@ namespace graphene { namespace chain {
   typedef multi_index_container<
     license_information_object,
     indexed_by<
-      ordered_unique< 
-        tag<by_id>,
-        member<object, object_id_type, &object::id> 
-      >,
       ordered_non_unique< 
         tag<by_account_id>,
           composite_key< license_information_object,
@@ -302,7 +300,62 @@ namespace graphene { namespace chain {
     >
   > license_information_multi_index_type;
 
-  typedef generic_index<license_information_object, license_information_multi_index_type> license_information_index;
+  typedef dense_index<license_information_object, license_information_multi_index_type> license_information_index;
+
+  /**
+   * @brief This secondary index keeps the cycles of all manually submitted licenses and their value in DasCoin.
+   *
+   * Every license information object contributes what database_access_layer::get_total_cycles reports for its
+   * vault. The contribution is replaced whenever the object changes, so the totals are available without walking
+   * the accounts.
+   */
+  class license_total_cycles_index : public secondary_index
+  {
+    public:
+      license_total_cycles_index( const database& db ) : _db(db) {}
+
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after ) override;
+
+      share_type total_cycles() const { return _total_cycles; }
+      share_type total_dascoin() const { return _total_dascoin; }
+
+      /// Computes the contribution of a single license information object to the totals.
+      void get_contribution( const license_information_object& lio, share_type& cycles, share_type& dascoin ) const;
+
+    private:
+      const database& _db;
+      share_type      _total_cycles = 0;
+      share_type      _total_dascoin = 0;
+      share_type      _before_cycles = 0;
+      share_type      _before_dascoin = 0;
+  };
+
+  /**
+   * @brief This secondary index finds the license information objects an upgrade event can still upgrade.
+   *
+   * An object is kept under the earliest activation time among its license records with remaining upgrades, so an
+   * upgrade event only visits the objects with such a record activated before its cutoff time.
+   */
+  class upgradeable_license_index : public secondary_index
+  {
+    public:
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after ) override;
+
+      /// @return the objects having a license record with remaining upgrades activated at or before cutoff_time
+      vector<license_information_id_type> activated_before( time_point_sec cutoff_time ) const;
+
+    private:
+      static optional<time_point_sec> earliest_upgradeable( const license_information_object& lio );
+
+      set< std::pair<time_point_sec, license_information_id_type> > _by_activation;
+      optional<time_point_sec>                                      _before_activation;
+  };
 
   struct by_name;
   struct by_amount;
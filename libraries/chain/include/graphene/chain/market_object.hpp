@@ -99,6 +99,34 @@ typedef multi_index_container<
 
 typedef generic_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
 
+/**
+ *  @brief tracks the distinct price levels of the limit order book
+ *
+ *  For every (sell asset, receive asset) pair this keeps the number of open orders at each price, ordered like the
+ *  by_price index. Best price queries step from one price level to the next instead of walking every order that
+ *  rests at the same price.
+ */
+class limit_order_price_level_index : public secondary_index
+{
+   public:
+      typedef std::map< price, uint32_t, std::greater<price> > price_levels;
+
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after ) override;
+
+      /// @return price levels of the orders selling @ref sell for @ref receive, best (highest) price first
+      const price_levels& get_levels( asset_id_type sell, asset_id_type receive )const;
+
+   private:
+      void add_level( const price& p );
+      void remove_level( const price& p );
+
+      map< pair<asset_id_type,asset_id_type>, price_levels > _levels;
+      price                                                  _before;
+};
+
 /**
  * @class call_order_object
  * @brief tracks debt and call price information
@@ -106,6 +106,7 @@ namespace graphene { namespace chain {
          account_id_type                      account; /// the account this operation applies to
          operation_history_id_type            operation_id;
          uint32_t                             sequence = 0; /// the operation position within the given account
+         uint32_t                             op_type = 0; /// the type (operation::which()) of the operation
          account_transaction_history_id_type  next;
 
          //std::pair<account_id_type,operation_history_id_type>  account_op()const  { return std::tie( account, operation_id ); }
@@ -115,6 +116,8 @@ namespace graphene { namespace chain {
    struct by_id;
 struct by_seq;
 struct by_op;
+struct by_op_type;
+struct by_opid;
 typedef multi_index_container<
    account_transaction_history_object,
    indexed_by<
@@ -130,6 +133,16 @@ typedef multi_index_container<
             member< account_transaction_history_object, account_id_type, &account_transaction_history_object::account>,
             member< account_transaction_history_object, operation_history_id_type, &account_transaction_history_object::operation_id>
          >
+      >,
+      ordered_unique< tag<by_op_type>,
+         composite_key< account_transaction_history_object,
+            member< account_transaction_history_object, account_id_type, &account_transaction_history_object::account>,
+            member< account_transaction_history_object, uint32_t, &account_transaction_history_object::op_type>,
+            member< account_transaction_history_object, uint32_t, &account_transaction_history_object::sequence>
+         >
+      >,
+      ordered_non_unique< tag<by_opid>,
+         member< account_transaction_history_object, operation_history_id_type, &account_transaction_history_object::operation_id>
       >
    >
 > account_transaction_history_multi_index_type;
@@ -143,4 +156,4 @@ FC_REFLECT_DERIVED( graphene::chain::operation_history_object, (graphene::chain:
                     (op)(result)(block_num)(block_timestamp)(trx_in_block)(op_in_trx)(virtual_op) )
 
 FC_REFLECT_DERIVED( graphene::chain::account_transaction_history_object, (graphene::chain::object),
-                    (account)(operation_id)(sequence)(next) )
+                    (account)(operation_id)(sequence)(op_type)(next) )
@@ -165,12 +165,22 @@ namespace graphene { namespace chain {
          uint32_t max_recursion = GRAPHENE_MAX_SIG_CHECK_DEPTH
          ) const;
 
-      flat_set<public_key_type> get_signature_keys( const chain_id_type& chain_id )const;
+      /**
+       *  Recovers the public keys from @ref signatures. Recovery is expensive, so the result is cached
+       *  on the transaction and reused for as long as neither the signed digest nor the signatures change.
+       *  This allows the keys to be recovered ahead of time, e.g. on another thread.
+       */
+      const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id )const;
 
       vector<signature_type> signatures;
 
       /// Removes all operations and signatures
       void clear() { operations.clear(); signatures.clear(); }
+
+   private:
+      mutable digest_type               _signees_digest;
+      mutable vector<signature_type>    _signees_signatures;
+      mutable flat_set<public_key_type> _signees;
    };
 
    void verify_authority( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
@@ -76,7 +76,8 @@ namespace graphene { namespace chain {
       ordered_unique< tag<by_id>,
         member<object, object_id_type, &object::id>
       >,
-      ordered_unique< tag<by_time>,
+      // ranked, the position in the queue and the pages are found with rank() and nth() in O(log n):
+      ranked_unique< tag<by_time>,
         composite_key< reward_queue_object,
           member< reward_queue_object, time_point_sec, &reward_queue_object::time>,
           member< object, object_id_type, &object::id>
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  @class virtual_op_database
+    *  @brief The virtual operations of every applied block, addressed by block number and operation type.
+    *
+    *  Like the block_database it consists of an index with one fixed size entry per block number and a data file.
+    *  The record of a block lists the operation types it holds, each with the packed operations of that type, so
+    *  reading some types of a block only unpacks those. The records are written once per applied block, in block
+    *  order; storing a block again, after a pop or during a replay, drops the records of that block and all later
+    *  ones.
+    */
+   class virtual_op_database
+   {
+      public:
+         ~virtual_op_database();
+
+         void open( const fc::path& dbdir );
+         bool is_open()const;
+         void flush();
+         void close();
+
+         /** Stores the virtual operations among the operations applied in the block */
+         void store( uint32_t block_num, const vector<optional<operation_history_object>>& applied_ops );
+
+         /** @return the virtual operations of the given types in the block, in the order they were applied */
+         vector<operation> fetch( uint32_t block_num, const vector<uint16_t>& op_types )const;
+
+      private:
+         detail::mapped_log_file _index;
+         detail::mapped_log_file _data;
+         uint64_t                _index_size = 0;
+         uint64_t                _data_size = 0;
+   };
+
+} }
@@ -23,6 +23,7 @@
  */
 
 #include <graphene/chain/license_objects.hpp>
+#include <graphene/chain/database.hpp>
 
 namespace graphene { namespace chain {
 
@@ -32,4 +33,105 @@ namespace graphene { namespace chain {
     FC_ASSERT( name.size() <= GRAPHENE_MAX_ACCOUNT_NAME_LENGTH );
   }
 
+  void license_total_cycles_index::get_contribution( const license_information_object& lio,
+                                                     share_type& cycles, share_type& dascoin ) const
+  {
+    cycles = 0;
+    dascoin = 0;
+    if ( !lio.is_manual_submit() )
+      return;
+
+    // Same as get_total_cycles: the DasCoin value of each record is taken from the cycles accumulated so far.
+    for ( const auto& record : lio.history )
+    {
+      cycles += record.total_cycles();
+      if ( record.frequency_lock != 0 )
+        dascoin += _db.cycles_to_dascoin(cycles, record.frequency_lock);
+    }
+  }
+
+  void license_total_cycles_index::object_inserted( const object& obj )
+  {
+    assert( dynamic_cast<const license_information_object*>(&obj) ); // for debug only
+    share_type cycles, dascoin;
+    get_contribution( static_cast<const license_information_object&>(obj), cycles, dascoin );
+    _total_cycles += cycles;
+    _total_dascoin += dascoin;
+  }
+
+  void license_total_cycles_index::object_removed( const object& obj )
+  {
+    assert( dynamic_cast<const license_information_object*>(&obj) ); // for debug only
+    share_type cycles, dascoin;
+    get_contribution( static_cast<const license_information_object&>(obj), cycles, dascoin );
+    _total_cycles -= cycles;
+    _total_dascoin -= dascoin;
+  }
+
+  void license_total_cycles_index::about_to_modify( const object& before )
+  {
+    assert( dynamic_cast<const license_information_object*>(&before) ); // for debug only
+    get_contribution( static_cast<const license_information_object&>(before), _before_cycles, _before_dascoin );
+  }
+
+  void license_total_cycles_index::object_modified( const object& after )
+  {
+    assert( dynamic_cast<const license_information_object*>(&after) ); // for debug only
+    share_type cycles, dascoin;
+    get_contribution( static_cast<const license_information_object&>(after), cycles, dascoin );
+    _total_cycles += cycles - _before_cycles;
+    _total_dascoin += dascoin - _before_dascoin;
+  }
+
+  optional<time_point_sec> upgradeable_license_index::earliest_upgradeable( const license_information_object& lio )
+  {
+    optional<time_point_sec> result;
+    for ( const auto& record : lio.history )
+      if ( record.balance_upgrade.has_remaining_upgrades() && ( !result.valid() || record.activated_at < *result ) )
+        result = record.activated_at;
+    return result;
+  }
+
+  vector<license_information_id_type> upgradeable_license_index::activated_before( time_point_sec cutoff_time ) const
+  {
+    vector<license_information_id_type> result;
+    for ( auto itr = _by_activation.begin(); itr != _by_activation.end() && itr->first <= cutoff_time; ++itr )
+      result.push_back( itr->second );
+    return result;
+  }
+
+  void upgradeable_license_index::object_inserted( const object& obj )
+  {
+    assert( dynamic_cast<const license_information_object*>(&obj) ); // for debug only
+    const auto activation = earliest_upgradeable( static_cast<const license_information_object&>(obj) );
+    if ( activation.valid() )
+      _by_activation.emplace( *activation, license_information_id_type(obj.id) );
+  }
+
+  void upgradeable_license_index::object_removed( const object& obj )
+  {
+    assert( dynamic_cast<const license_information_object*>(&obj) ); // for debug only
+    const auto activation = earliest_upgradeable( static_cast<const license_information_object&>(obj) );
+    if ( activation.valid() )
+      _by_activation.erase( std::make_pair( *activation, license_information_id_type(obj.id) ) );
+  }
+
+  void upgradeable_license_index::about_to_modify( const object& before )
+  {
+    assert( dynamic_cast<const license_information_object*>(&before) ); // for debug only
+    _before_activation = earliest_upgradeable( static_cast<const license_information_object&>(before) );
+  }
+
+  void upgradeable_license_index::object_modified( const object& after )
+  {
+    assert( dynamic_cast<const license_information_object*>(&after) ); // for debug only
+    const auto activation = earliest_upgradeable( static_cast<const license_information_object&>(after) );
+    if ( activation.valid() == _before_activation.valid() && ( !activation.valid() || *activation == *_before_activation ) )
+      return;
+    if ( _before_activation.valid() )
+      _by_activation.erase( std::make_pair( *_before_activation, license_information_id_type(after.id) ) );
+    if ( activation.valid() )
+      _by_activation.emplace( *activation, license_information_id_type(after.id) );
+  }
+
 } } // namespace graphene::chain
@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <graphene/chain/market_object.hpp>
+
+namespace graphene { namespace chain {
+
+void limit_order_price_level_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const limit_order_object*>(&obj) ); // for debug only
+   add_level( static_cast<const limit_order_object&>(obj).sell_price );
+}
+
+void limit_order_price_level_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const limit_order_object*>(&obj) ); // for debug only
+   remove_level( static_cast<const limit_order_object&>(obj).sell_price );
+}
+
+void limit_order_price_level_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const limit_order_object*>(&before) ); // for debug only
+   _before = static_cast<const limit_order_object&>(before).sell_price;
+}
+
+void limit_order_price_level_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const limit_order_object*>(&after) ); // for debug only
+   const auto& order = static_cast<const limit_order_object&>(after);
+   // Price comparison is by ratio, so only a genuine move to another level touches the map:
+   if( order.sell_price != _before )
+   {
+      remove_level( _before );
+      add_level( order.sell_price );
+   }
+}
+
+const limit_order_price_level_index::price_levels& limit_order_price_level_index::get_levels( asset_id_type sell, asset_id_type receive )const
+{
+   static const price_levels empty;
+   auto itr = _levels.find( std::make_pair( sell, receive ) );
+   return itr == _levels.end() ? empty : itr->second;
+}
+
+void limit_order_price_level_index::add_level( const price& p )
+{
+   ++_levels[ std::make_pair( p.base.asset_id, p.quote.asset_id ) ][ p ];
+}
+
+void limit_order_price_level_index::remove_level( const price& p )
+{
+   auto market_itr = _levels.find( std::make_pair( p.base.asset_id, p.quote.asset_id ) );
+   assert( market_itr != _levels.end() );
+   if( market_itr == _levels.end() )
+      return;
+
+   auto& levels = market_itr->second;
+   auto level_itr = levels.find( p );
+   assert( level_itr != levels.end() );
+   if( level_itr == levels.end() )
+      return;
+
+   if( --level_itr->second == 0 )
+   {
+      levels.erase( level_itr );
+      if( levels.empty() )
+         _levels.erase( market_itr );
+   }
+}
+
+} } // graphene::chain
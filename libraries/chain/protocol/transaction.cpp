@@ -297,10 +297,14 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
 } FC_CAPTURE_AND_RETHROW( (ops)(sigs) ) }
 
 
-flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id_type& chain_id )const
+const flat_set<public_key_type>& signed_transaction::get_signature_keys( const chain_id_type& chain_id )const
 { try {
    auto d = sig_digest( chain_id );
+   if( !_signees_signatures.empty() && _signees_digest == d && _signees_signatures == signatures )
+      return _signees;
+
    flat_set<public_key_type> result;
+   result.reserve( signatures.size() );
    for( const auto&  sig : signatures )
    {
       GRAPHENE_ASSERT(
@@ -308,7 +312,11 @@ flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id
          tx_duplicate_sig,
          "Duplicate Signature detected" );
    }
-   return result;
+
+   _signees = std::move( result );
+   _signees_digest = d;
+   _signees_signatures = signatures;
+   return _signees;
 } FC_CAPTURE_AND_RETHROW() }
 
 
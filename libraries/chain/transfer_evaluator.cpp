@@ -187,11 +187,13 @@ void_result transfer_vault_to_wallet_evaluator::do_evaluate(const transfer_vault
    // If dascoin is being transferred, check daily limit constraint:
    if ( !from_acc_obj.disable_vault_to_wallet_limit && op.asset_to_transfer.asset_id == d.get_dascoin_asset_id() )
    {
-      FC_ASSERT( from_balance_obj.spent + op.asset_to_transfer.amount <= from_balance_obj.limit,
+      const share_type spent = d.get_spent_amount(from_balance_obj);
+      const share_type limit = d.get_spending_limit(from_balance_obj);
+      FC_ASSERT( spent + op.asset_to_transfer.amount <= limit,
                  "Cash limit has been exceeded, ${spent}/${max} on account ${a}",
                  ("a",from_acc_obj.name)
-                 ("spent",d.to_pretty_string(from_balance_obj.get_spent_balance()))
-                 ("max",d.to_pretty_string(asset(from_balance_obj.limit, op.asset_to_transfer.asset_id)))
+                 ("spent",d.to_pretty_string(asset(spent, op.asset_to_transfer.asset_id)))
+                 ("max",d.to_pretty_string(asset(limit, op.asset_to_transfer.asset_id)))
                );
    }
 
@@ -205,6 +207,7 @@ void_result transfer_vault_to_wallet_evaluator::do_apply(const transfer_vault_to
 { try {
    auto& d = db();
 
+   d.update_spending_limit(*from_balance_obj_);
    d.modify(*from_balance_obj_, [&](account_balance_object& from_b){
     from_b.balance -= op.asset_to_transfer.amount;
     from_b.reserved -= op.reserved_to_transfer;
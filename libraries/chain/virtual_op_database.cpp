@@ -0,0 +1,245 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <graphene/chain/virtual_op_database.hpp>
+#include <graphene/chain/protocol/fee_schedule.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+struct vop_index_entry
+{
+   uint64_t pos = 0;     ///< where the record of the block starts, or would start if it had one
+   uint32_t size = 0;    ///< 0 if the block has no virtual operations
+   uint32_t stored = 0;  ///< 1 once the block was stored, 0 for the blocks before the first stored one
+};
+
+/** The record of a block starts with the number of types, followed by one of these per type */
+struct vop_type_entry
+{
+   uint32_t op_type = 0;
+   uint32_t offset = 0;  ///< of the packed operations, from the start of the record
+   uint32_t size = 0;
+};
+
+const uint64_t index_chunk_size = 1024 * 1024;
+const uint64_t data_chunk_size  = 16 * 1024 * 1024;
+
+/**
+ *  Packs the operations of one type like a vector< pair<uint32_t, operation> >, the first member being the position
+ *  of the operation among the virtual operations of the block. ops holds that position and the index of the
+ *  operation in applied_ops.
+ */
+template<typename Stream>
+void pack_operations( Stream& s, const vector<optional<operation_history_object>>& applied_ops,
+                      const vector<std::pair<uint32_t, uint32_t>>& ops )
+{
+   fc::raw::pack( s, fc::unsigned_int( (uint32_t)ops.size() ) );
+   for( const auto& o : ops )
+   {
+      fc::raw::pack( s, o.first );
+      fc::raw::pack( s, applied_ops[o.second]->op );
+   }
+}
+
+} // anonymous
+
+virtual_op_database::~virtual_op_database()
+{
+   try
+   {
+      if( is_open() )
+         close();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Error closing virtual operation database: ${e}", ("e", e.to_detail_string()) );
+   }
+}
+
+void virtual_op_database::open( const fc::path& dbdir )
+{ try {
+   fc::create_directories( dbdir );
+   _index.open( dbdir / "index", index_chunk_size );
+   _data.open( dbdir / "operations", data_chunk_size );
+
+   // After an unclean shutdown the files still carry the zero filled space they were grown by,
+   // the last stored block marks the end of both.
+   _index_size = _index.file_size() - _index.file_size() % sizeof(vop_index_entry);
+   _data_size = 0;
+   vop_index_entry e;
+   while( _index_size >= sizeof(e) )
+   {
+      memcpy( (char*)&e, _index.data() + _index_size - sizeof(e), sizeof(e) );
+      if( e.stored )
+      {
+         _data_size = std::min( e.pos + e.size, _data.file_size() );
+         break;
+      }
+      _index_size -= sizeof(e);
+   }
+} FC_CAPTURE_AND_RETHROW( (dbdir) ) }
+
+bool virtual_op_database::is_open()const
+{
+   return _data.is_open();
+}
+
+void virtual_op_database::flush()
+{
+   _data.flush();
+   _index.flush();
+}
+
+void virtual_op_database::close()
+{
+   if( !is_open() )
+      return;
+   _data.close( _data_size );
+   _index.close( _index_size );
+   _data_size = 0;
+   _index_size = 0;
+}
+
+void virtual_op_database::store( uint32_t block_num, const vector<optional<operation_history_object>>& applied_ops )
+{ try {
+   FC_ASSERT( is_open() );
+
+   // Group the virtual operations by type, keeping their position among the virtual operations of the block:
+   flat_map< uint32_t, vector<std::pair<uint32_t, uint32_t>> > by_type;
+   uint32_t position = 0;
+   for( uint32_t i = 0; i < applied_ops.size(); ++i )
+   {
+      if( applied_ops[i].valid() && operation_type_limits::is_virtual_operation( applied_ops[i]->op ) )
+         by_type[ applied_ops[i]->op.which() ].emplace_back( position++, i );
+   }
+
+   const uint64_t index_pos = uint64_t( block_num ) * sizeof(vop_index_entry);
+   vop_index_entry e;
+   if( index_pos < _index_size )
+   {
+      // The block is applied again, the records of this and all later blocks are stale:
+      memcpy( (char*)&e, _index.data() + index_pos, sizeof(e) );
+      memset( _index.data() + index_pos, 0, _index_size - index_pos );
+      _data_size = e.pos;
+      _index_size = index_pos;
+   }
+   else if( index_pos > _index_size )
+   {
+      // The blocks applied before the store was opened, e.g. when starting from a snapshot, have no records:
+      _index.reserve( index_pos );
+      vop_index_entry missing;
+      missing.pos = _data_size;
+      for( uint64_t pos = _index_size; pos < index_pos; pos += sizeof(missing) )
+         memcpy( _index.data() + pos, (const char*)&missing, sizeof(missing) );
+      _index_size = index_pos;
+   }
+
+   e = vop_index_entry();
+   e.pos = _data_size;
+   e.stored = 1;
+   if( !by_type.empty() )
+   {
+      vector<vop_type_entry> types( by_type.size() );
+      uint32_t offset = sizeof(uint32_t) + types.size() * sizeof(vop_type_entry);
+      size_t i = 0;
+      for( const auto& t : by_type )
+      {
+         fc::datastream<size_t> ps;
+         pack_operations( ps, applied_ops, t.second );
+         types[i].op_type = t.first;
+         types[i].offset = offset;
+         types[i].size = ps.tellp();
+         offset += types[i].size;
+         ++i;
+      }
+      e.size = offset;
+
+      _data.reserve( e.pos + e.size );
+      char* record = _data.data() + e.pos;
+      const uint32_t type_count = types.size();
+      memcpy( record, (const char*)&type_count, sizeof(type_count) );
+      memcpy( record + sizeof(type_count), (const char*)types.data(), types.size() * sizeof(vop_type_entry) );
+      i = 0;
+      for( const auto& t : by_type )
+      {
+         fc::datastream<char*> ds( record + types[i].offset, types[i].size );
+         pack_operations( ds, applied_ops, t.second );
+         ++i;
+      }
+      _data_size += e.size;
+   }
+
+   _index.reserve( index_pos + sizeof(e) );
+   memcpy( _index.data() + index_pos, (const char*)&e, sizeof(e) );
+   _index_size = index_pos + sizeof(e);
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
+vector<operation> virtual_op_database::fetch( uint32_t block_num, const vector<uint16_t>& op_types )const
+{ try {
+   vector<operation> result;
+   const uint64_t index_pos = uint64_t( block_num ) * sizeof(vop_index_entry);
+   if( index_pos + sizeof(vop_index_entry) > _index_size )
+      return result;
+
+   vop_index_entry e;
+   memcpy( (char*)&e, _index.data() + index_pos, sizeof(e) );
+   if( e.size == 0 )
+      return result;
+
+   const char* record = _data.data() + e.pos;
+   uint32_t type_count = 0;
+   memcpy( (char*)&type_count, record, sizeof(type_count) );
+
+   vector<std::pair<uint32_t, operation>> ops;
+   for( uint32_t i = 0; i < type_count; ++i )
+   {
+      vop_type_entry t;
+      memcpy( (char*)&t, record + sizeof(type_count) + i * sizeof(t), sizeof(t) );
+      if( std::find( op_types.begin(), op_types.end(), t.op_type ) == op_types.end() )
+         continue;
+
+      vector<std::pair<uint32_t, operation>> of_type;
+      fc::datastream<const char*> ds( record + t.offset, t.size );
+      fc::raw::unpack( ds, of_type );
+      std::move( of_type.begin(), of_type.end(), std::back_inserter( ops ) );
+   }
+
+   // Back in the order the operations were applied:
+   std::sort( ops.begin(), ops.end(), []( const std::pair<uint32_t, operation>& a,
+                                          const std::pair<uint32_t, operation>& b ) {
+      return a.first < b.first;
+   } );
+   result.reserve( ops.size() );
+   for( auto& o : ops )
+      result.push_back( std::move( o.second ) );
+   return result;
+} FC_CAPTURE_AND_RETHROW( (block_num)(op_types) ) }
+
+} }
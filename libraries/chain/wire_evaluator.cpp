@@ -66,6 +66,7 @@ namespace graphene { namespace chain {
   { try {
     auto& d = db();
     // Adjust the balance and spent amount:
+    d.update_spending_limit(*from_balance_obj_);
     d.modify(*from_balance_obj_, [&](account_balance_object& from_b){
      from_b.balance -= op.asset_to_wire.amount;
      from_b.spent += op.asset_to_wire.amount;
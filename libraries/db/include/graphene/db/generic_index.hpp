@@ -26,6 +26,7 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
 namespace graphene { namespace chain {
@@ -126,4 +127,160 @@ namespace graphene { namespace chain {
       >
    >>{};
 
+   /**
+    *  A generic_index variant for object types whose instances are allocated densely and rarely removed, such as
+    *  accounts and balances. The objects live in the multi_index container, which only holds the secondary keys
+    *  and must not have a by_id index. Lookups by id go through a table of pointers indexed by instance, which
+    *  replaces the by_id tree with an O(1) array access. Iterating the index itself visits the objects in id order.
+    */
+   template<typename ObjectType, typename MultiIndexType>
+   class dense_index : public index
+   {
+      public:
+         typedef MultiIndexType index_type;
+         typedef ObjectType     object_type;
+
+         virtual const object& insert( object&& obj )override
+         {
+            assert( nullptr != dynamic_cast<ObjectType*>(&obj) );
+            const auto instance = obj.id.instance();
+            FC_ASSERT( instance >= _objects.size() || _objects[instance] == nullptr,
+                       "Could not insert object, an object with this id already exists" );
+            auto insert_result = _indices.insert( std::move( static_cast<ObjectType&>(obj) ) );
+            FC_ASSERT( insert_result.second, "Could not insert object, most likely a uniqueness constraint was violated" );
+            if( instance >= _objects.size() ) _objects.resize( instance + 1 );
+            _objects[instance] = &*insert_result.first;
+            return *insert_result.first;
+         }
+
+         virtual const object&  create(const std::function<void(object&)>& constructor )override
+         {
+            ObjectType item;
+            item.id = get_next_id();
+            constructor( item );
+            item.id = get_next_id(); // the instance is the position in the table, it must not change
+            auto insert_result = _indices.insert( std::move(item) );
+            FC_ASSERT(insert_result.second, "Could not create object! Most likely a uniqueness constraint is violated.");
+            const auto instance = insert_result.first->id.instance();
+            if( instance >= _objects.size() ) _objects.resize( instance + 1 );
+            _objects[instance] = &*insert_result.first;
+            use_next_id();
+            return *insert_result.first;
+         }
+
+         virtual void modify( const object& obj, const std::function<void(object&)>& m )override
+         {
+            assert( nullptr != dynamic_cast<const ObjectType*>(&obj) );
+            const object_id_type id = obj.id;
+            auto ok = _indices.modify( _indices.iterator_to( static_cast<const ObjectType&>(obj) ),
+                                       [&m]( ObjectType& o ){ m(o); } );
+            if( !ok )
+            {
+               // the container has erased the object, like generic_index its table entry must go as well
+               release( id.instance() );
+               FC_THROW_EXCEPTION( fc::assert_exception,
+                                   "Could not modify object, most likely a index constraint was violated" );
+            }
+            FC_ASSERT( obj.id == id, "The id of an object cannot be modified" );
+         }
+
+         virtual void remove( const object& obj )override
+         {
+            const auto instance = obj.id.instance();
+            assert( instance < _objects.size() && _objects[instance] == &obj );
+            _indices.erase( _indices.iterator_to( static_cast<const ObjectType&>(obj) ) );
+            release( instance );
+         }
+
+         virtual void reserve( size_t count )override
+         {
+            _objects.reserve( count );
+         }
+
+         virtual const object* find( object_id_type id )const override
+         {
+            assert( id.space() == ObjectType::space_id );
+            assert( id.type() == ObjectType::type_id );
+
+            const auto instance = id.instance();
+            if( instance >= _objects.size() ) return nullptr;
+            return _objects[instance];
+         }
+
+         virtual void inspect_all_objects(std::function<void (const object&)> inspector)const override
+         {
+            try {
+               for( const auto& obj : *this )
+                  inspector(obj);
+            } FC_CAPTURE_AND_RETHROW()
+         }
+
+         const index_type& indices()const { return _indices; }
+
+         virtual fc::uint128 hash()const override {
+            fc::uint128 result;
+            for( const auto& obj : _indices )
+            {
+               result += obj.hash();
+            }
+
+            return result;
+         }
+
+         class const_iterator
+         {
+            public:
+               typedef typename vector<const ObjectType*>::const_iterator base_iterator;
+
+               const_iterator( base_iterator itr, base_iterator end ):_itr(itr),_end(end) { skip_removed(); }
+               friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._itr == b._itr; }
+               friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._itr != b._itr; }
+               const ObjectType& operator*()const  { return **_itr; }
+               const ObjectType* operator->()const { return *_itr; }
+               const_iterator operator++(int)     // postfix
+               {
+                  const_iterator result( *this );
+                  ++(*this);
+                  return result;
+               }
+               const_iterator& operator++()       // prefix
+               {
+                  ++_itr;
+                  skip_removed();
+                  return *this;
+               }
+               typedef std::forward_iterator_tag iterator_category;
+               typedef ObjectType                value_type;
+               typedef std::ptrdiff_t            difference_type;
+               typedef const ObjectType*         pointer;
+               typedef const ObjectType&         reference;
+            private:
+               void skip_removed()
+               {
+                  while( _itr != _end && *_itr == nullptr )
+                     ++_itr;
+               }
+
+               base_iterator _itr;
+               base_iterator _end;
+         };
+         /** iterates all objects in the order of their ids, they may be modified but not created or removed meanwhile */
+         const_iterator begin()const { return const_iterator( _objects.begin(), _objects.end() ); }
+         const_iterator end()const   { return const_iterator( _objects.end(), _objects.end() );   }
+
+         size_t size()const { return _indices.size(); }
+
+      private:
+         /** Clears the table entry of a removed object, the table ends with the last object */
+         void release( uint64_t instance )
+         {
+            _objects[instance] = nullptr;
+            while( !_objects.empty() && _objects.back() == nullptr )
+               _objects.pop_back();
+         }
+
+         vector< const ObjectType* > _objects;
+         index_type                  _indices;
+   };
+
 } }
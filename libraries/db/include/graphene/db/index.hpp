@@ -23,10 +23,12 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <graphene/db/undo_database.hpp>
 #include <fc/interprocess/file_mapping.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
+#include <algorithm>
 #include <fstream>
 
 namespace graphene { namespace db {
@@ -78,6 +80,13 @@ namespace graphene { namespace db {
          virtual void           set_next_id( object_id_type id ) = 0;
 
          virtual const object&  load( const std::vector<char>& data ) = 0;
+
+         /**
+          *  Hint that count objects are about to be loaded, so that indexes which
+          *  can allocate their storage up front may do so.
+          */
+         virtual void reserve( size_t count ) {}
+
          /**
           *  Polymorphically insert by moving an object into the index.
           *  this should throw if the object is already in the database.
@@ -96,6 +105,20 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  Packs the index into result in the format written by save(), as it was before the changes in image.
+          *  The result no longer refers to the index, so it may be written out while the index keeps changing.
+          */
+         virtual void pack( const undo_image& image, vector<char>& result )const = 0;
+
+         /**
+          *  @return false if the index is known to be unchanged since it was last opened from or saved to
+          *  the object database, in which case flushing may keep its file as it is.
+          */
+         virtual bool is_dirty()const { return true; }
+         /** Called after the index has been saved to the object database */
+         virtual void set_clean() {}
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -152,22 +175,24 @@ namespace graphene { namespace db {
       public:
          base_primary_index( object_database& db ):_db(db){}
 
-         /** called just before obj is modified */
-         void save_undo( const object& obj );
+         /** called just before obj is modified, copy saves its old value as the concrete type */
+         void save_undo( const object& obj, undo_copy_function copy );
 
          /** called just after the object is added */
          void on_add( const object& obj );
 
          /** called just before obj is removed */
-         void on_remove( const object& obj );
+         void on_remove( const object& obj, undo_copy_function copy );
 
          /** called just after obj is modified */
          void on_modify( const object& obj );
 
-         template<typename T>
-         void add_secondary_index()
+         template<typename T, typename... Args>
+         T* add_secondary_index( Args&&... args )
          {
-            _sindex.emplace_back( new T() );
+            T* result = new T( std::forward<Args>( args )... );
+            _sindex.emplace_back( result );
+            return result;
          }
 
          template<typename T>
@@ -213,15 +238,23 @@ namespace graphene { namespace db {
          { return object_type::type_id; }
 
          virtual object_id_type get_next_id()const override              { return _next_id;    }
-         virtual void           use_next_id()override                    { ++_next_id.number;  }
-         virtual void           set_next_id( object_id_type id )override { _next_id = id;      }
+         virtual void           use_next_id()override                    { ++_next_id.number; _dirty = true; }
+         virtual void           set_next_id( object_id_type id )override { _next_id = id; _dirty = true;     }
+
+         virtual bool is_dirty()const override { return _dirty;  }
+         virtual void set_clean() override     { _dirty = false; }
 
          fc::sha256 get_object_version()const
          {
-            std::string desc = "1.0";//get_type_description<object_type>();
+            std::string desc = "1.1";//get_type_description<object_type>();
             return fc::sha256::hash(desc);
          }
 
+         /**
+          *  The file starts with the next id, the object version and the number of objects,
+          *  followed by one record per object: its packed size as a fixed width uint32_t and
+          *  the packed object, which is unpacked straight from the mapped file.
+          */
          virtual void open( const path& db )override
          { 
             if( !fc::exists( db ) ) return;
@@ -229,18 +262,26 @@ namespace graphene { namespace db {
             fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
             fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
             fc::sha256 open_ver;
+            uint64_t count = 0;
 
             fc::raw::unpack(ds, _next_id);
             fc::raw::unpack(ds, open_ver);
             FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
-            try {
-               vector<char> tmp;
-               while( true ) 
-               {
-                  fc::raw::unpack( ds, tmp );
-                  load( tmp );
-               }
-            } catch ( const fc::exception&  ){}
+            fc::raw::unpack(ds, count);
+
+            this->reserve( count );
+            for( uint64_t i = 0; i < count; ++i )
+            {
+               uint32_t size = 0;
+               fc::raw::unpack( ds, size );
+               FC_ASSERT( ds.remaining() >= size, "Truncated object in ${f}", ("f", db) );
+               fc::datastream<const char*> record( ds.pos(), size );
+               object_type obj;
+               fc::raw::unpack( record, obj );
+               insert_and_notify( std::move( obj ) );
+               ds.skip( size );
+            }
+            _dirty = false;
          }
 
          virtual void save( const path& db ) override 
@@ -249,26 +290,84 @@ namespace graphene { namespace db {
                                std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
             FC_ASSERT( out );
             auto ver  = get_object_version();
+            uint64_t count = 0;
+            this->inspect_all_objects( [&]( const object& ) { ++count; } );
             fc::raw::pack( out, _next_id );
             fc::raw::pack( out, ver );
+            fc::raw::pack( out, count );
+
+            vector<char> buffer;
+            this->inspect_all_objects( [&]( const object& o ) {
+                const auto& obj = static_cast<const object_type&>(o);
+                const uint32_t size = fc::raw::pack_size( obj );
+                buffer.resize( size );
+                fc::datastream<char*> ds( buffer.data(), size );
+                fc::raw::pack( ds, obj );
+                fc::raw::pack( out, size );
+                out.write( buffer.data(), size );
+            });
+         }
+
+         virtual void pack( const undo_image& image, vector<char>& result )const override
+         {
+            const undo_image::index_changes* changes = image.changes_of( object_type::space_id, object_type::type_id );
+            object_id_type next_id = _next_id;
+            vector<const object_type*> objects;
             this->inspect_all_objects( [&]( const object& o ) {
-                auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
-                auto packed_vec = fc::raw::pack( vec );
-                out.write( packed_vec.data(), packed_vec.size() );
+               if( changes == nullptr || changes->old_values.find( o.id ) == changes->old_values.end() )
+                  objects.push_back( &static_cast<const object_type&>( o ) );
             });
+            if( changes != nullptr )
+            {
+               for( const auto& item : changes->old_values )
+                  if( item.second != nullptr )
+                     objects.push_back( &static_cast<const object_type&>( *item.second ) );
+               std::sort( objects.begin(), objects.end(), []( const object_type* a, const object_type* b ) {
+                  return a->id < b->id;
+               });
+               if( changes->next_id.valid() )
+                  next_id = *changes->next_id;
+            }
+
+            const auto ver = get_object_version();
+            const uint64_t count = objects.size();
+            vector<uint32_t> sizes;
+            sizes.reserve( objects.size() );
+            size_t total = fc::raw::pack_size( next_id ) + fc::raw::pack_size( ver ) + fc::raw::pack_size( count );
+            for( const object_type* obj : objects )
+            {
+               sizes.push_back( fc::raw::pack_size( *obj ) );
+               total += sizeof(uint32_t) + sizes.back();
+            }
+
+            result.resize( total );
+            fc::datastream<char*> ds( result.data(), result.size() );
+            fc::raw::pack( ds, next_id );
+            fc::raw::pack( ds, ver );
+            fc::raw::pack( ds, count );
+            for( size_t i = 0; i < objects.size(); ++i )
+            {
+               fc::raw::pack( ds, sizes[i] );
+               fc::raw::pack( ds, *objects[i] );
+            }
          }
 
          virtual const object&  load( const std::vector<char>& data )override
          {
-            const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
-            for( const auto& item : _sindex )
-               item->object_inserted( result );
-            return result;
+            _dirty = true;
+            return insert_and_notify( fc::raw::unpack<object_type>( data ) );
          }
 
 
+         virtual const object& insert( object&& obj )override
+         {
+            _dirty = true;
+            return insert_and_notify( std::move( static_cast<object_type&>( obj ) ) );
+         }
+
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
+            _dirty = true;
             const auto& result = DerivedIndex::create( constructor );
             for( const auto& item : _sindex )
                item->object_inserted( result );
@@ -278,15 +377,17 @@ namespace graphene { namespace db {
 
          virtual void  remove( const object& obj ) override
          {
+            _dirty = true;
             for( const auto& item : _sindex )
                item->object_removed( obj );
-            on_remove(obj);
+            on_remove( obj, &undo_copy<object_type> );
             DerivedIndex::remove(obj);
          }
 
          virtual void modify( const object& obj, const std::function<void(object&)>& m )override
          {
-            save_undo( obj );
+            save_undo( obj, &undo_copy<object_type> );
+            _dirty = true;
             for( const auto& item : _sindex )
                item->about_to_modify( obj );
             DerivedIndex::modify( obj, m );
@@ -319,7 +420,17 @@ namespace graphene { namespace db {
          }
 
       private:
+         const object& insert_and_notify( object_type&& obj )
+         {
+            const auto& result = DerivedIndex::insert( std::move( obj ) );
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            return result;
+         }
+
          object_id_type _next_id;
+         /// whether the index changed since it was opened or last saved to the object database
+         bool           _dirty = true;
    };
 
 } } // graphene::db
@@ -25,9 +25,12 @@
 #include <graphene/db/object.hpp>
 #include <graphene/db/index.hpp>
 #include <graphene/db/undo_database.hpp>
+#include <graphene/db/snapshot_cache.hpp>
 
 #include <fc/log/logger.hpp>
 
+#include <atomic>
+#include <future>
 #include <map>
 
 namespace graphene { namespace db {
@@ -47,9 +50,35 @@ namespace graphene { namespace db {
          void open(const fc::path& data_dir);
 
          /**
-          * Saves the complete state of the object_database to disk, this could take a while
+          * Saves the complete state of the object_database to disk. Only the indexes that changed since they
+          * were last opened or saved are written, the files of the others are carried over.
           */
          void flush();
+         /**
+          * Writes every index into dir/<space>/<type>, the layout that open() reads
+          */
+         void save_indexes( const fc::path& dir );
+
+         /// Index files packed in memory, along with their paths relative to the object database directory
+         typedef vector< std::pair< fc::path, vector<char> > > packed_indexes;
+
+         /**
+          * Packs every index as it was before the newest undo_states undo states, in the layout save_indexes()
+          * writes. The indexes are packed in parallel, and the result does not refer to the database, so it can
+          * be written out by another thread while the database keeps changing.
+          */
+         packed_indexes pack_indexes( size_t undo_states )const;
+         /** Writes indexes packed by pack_indexes() into dir */
+         static void write_indexes( const packed_indexes& indexes, const fc::path& dir );
+
+         /**
+          * Like flush(), but saves the indexes as they were before the newest undo_states undo states. Only the
+          * packing is done by the caller, the files are written by a background thread.
+          * @return false if nothing was done because the previous background flush is still being written
+          */
+         bool flush_async( size_t undo_states );
+         /** Waits until the files of the last background flush are written */
+         void wait_for_flush();
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
@@ -156,16 +185,23 @@ namespace graphene { namespace db {
          index& get_mutable_index(object_id_type id)  { return get_mutable_index(id.space(),id.type());   }
          index& get_mutable_index(uint8_t space_id, uint8_t type_id);
 
+         /** Results of whole-index read queries, computed once per block and shared by all readers */
+         snapshot_cache& snapshots()const { return _snapshots; }
+
      private:
 
          friend class base_primary_index;
          friend class undo_database;
-         void save_undo( const object& obj );
+         void save_undo( const object& obj, undo_copy_function copy );
          void save_undo_add( const object& obj );
-         void save_undo_remove( const object& obj );
+         void save_undo_remove( const object& obj, undo_copy_function copy );
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+         mutable snapshot_cache                                    _snapshots;
+         /// set when a flush failed after marking indexes clean, the next flush writes every index
+         std::atomic<bool>                                         _flush_failed{ false };
+         std::future<void>                                         _flush_writer;
    };
 
 } } // graphene::db
@@ -69,6 +69,11 @@ namespace graphene { namespace db {
             return *_objects[instance];
          }
 
+         virtual void reserve( size_t count ) override
+         {
+            _objects.reserve( count );
+         }
+
          virtual void remove( const object& obj ) override
          {
             assert( nullptr != dynamic_cast<const T*>(&obj) );
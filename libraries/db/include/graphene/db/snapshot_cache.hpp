@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace graphene { namespace db {
+
+   /**
+    *  @class snapshot_cache
+    *  @brief Values computed from the state of the database once per block, shared by all readers
+    *
+    *  Expensive read only queries over whole indexes register how to compute their result with add(). The
+    *  owner of the database calls rebuild() after a block is applied or popped, while the state holds no
+    *  pending transactions, and every reader until the next rebuild() shares the same immutable value.
+    */
+   class snapshot_cache
+   {
+      public:
+         /** Registers how to compute the value published under name, unless it is registered already */
+         template<typename T>
+         void add( const std::string& name, const std::function<T()>& compute )
+         {
+            std::lock_guard<std::mutex> guard( _mutex );
+            _builders.emplace( name, [compute]() -> std::shared_ptr<const void> {
+               return std::make_shared<const T>( compute() );
+            });
+         }
+
+         /** @return the value published under name by the last rebuild(), or null if there is none yet */
+         template<typename T>
+         std::shared_ptr<const T> get( const std::string& name )const
+         {
+            std::lock_guard<std::mutex> guard( _mutex );
+            auto itr = _values.find( name );
+            if( itr == _values.end() )
+               return std::shared_ptr<const T>();
+            return std::static_pointer_cast<const T>( itr->second );
+         }
+
+         /** Computes every registered value from the current state and publishes it */
+         void rebuild()
+         {
+            std::unordered_map< std::string, std::function<std::shared_ptr<const void>()> > builders;
+            {
+               std::lock_guard<std::mutex> guard( _mutex );
+               if( _builders.empty() )
+                  return;
+               builders = _builders;
+            }
+
+            std::unordered_map< std::string, std::shared_ptr<const void> > values;
+            for( const auto& builder : builders )
+               values.emplace( builder.first, builder.second() );
+
+            std::lock_guard<std::mutex> guard( _mutex );
+            _values.swap( values );
+         }
+
+      private:
+         mutable std::mutex                                                                  _mutex;
+         std::unordered_map< std::string, std::function<std::shared_ptr<const void>()> >     _builders;
+         std::unordered_map< std::string, std::shared_ptr<const void> >                      _values;
+   };
+
+} } // graphene::db
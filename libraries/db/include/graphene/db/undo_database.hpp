@@ -24,7 +24,11 @@
 #pragma once
 #include <graphene/db/object.hpp>
 #include <deque>
+#include <map>
+#include <new>
+#include <unordered_map>
 #include <fc/exception/exception.hpp>
+#include <fc/optional.hpp>
 
 namespace graphene { namespace db {
 
@@ -32,12 +36,124 @@ namespace graphene { namespace db {
    using fc::flat_set;
    class object_database;
 
+   /**
+    * @class undo_arena
+    * @brief Bump allocator holding the old values of the objects saved by an undo state
+    *
+    * Old values are copy constructed into large blocks instead of being cloned one heap allocation
+    * at a time. They are destroyed together with the arena, unless splice() has handed them over
+    * to another arena first.
+    */
+   class undo_arena
+   {
+      public:
+         undo_arena() {}
+         undo_arena( undo_arena&& other ) { splice( other ); }
+         undo_arena& operator = ( undo_arena&& other ) { clear(); splice( other ); return *this; }
+         ~undo_arena() { clear(); }
+
+         /** The allocation state of the arena, everything allocated after it can be released by rewind() */
+         struct mark_type
+         {
+            size_t blocks  = 0;
+            size_t objects = 0;
+            char*  pos     = nullptr;
+            char*  end     = nullptr;
+         };
+
+         template<typename T>
+         T* copy( const T& obj )
+         {
+            T* result = new ( allocate( sizeof(T), alignof(T) ) ) T( obj );
+            _objects.push_back( result );
+            return result;
+         }
+
+         /** Takes over all memory and objects of other, which is left empty */
+         void splice( undo_arena& other );
+         void clear();
+
+         mark_type mark()const { return mark_type{ _blocks.size(), _objects.size(), _pos, _end }; }
+         /** Destroys the objects copied since m was taken and frees the blocks allocated since */
+         void rewind( const mark_type& m );
+
+      private:
+         void* allocate( size_t size, size_t align );
+
+         vector< unique_ptr<char[]> > _blocks;
+         char*                        _pos = nullptr;
+         char*                        _end = nullptr;
+         vector< object* >            _objects;
+   };
+
+   /** Copies obj into the arena as its concrete type, passed by the index which knows that type */
+   typedef object* (*undo_copy_function)( undo_arena& arena, const object& obj );
+
+   template<typename T>
+   object* undo_copy( undo_arena& arena, const object& obj )
+   {
+      return arena.copy( static_cast<const T&>( obj ) );
+   }
+
+   /**
+    * A change made to a single object within an undo state, describing the combined effect of all changes made
+    * to it since the innermost savepoint of the state. Without savepoints an object has at most one record per
+    * state, each savepoint may add another one.
+    */
+   struct undo_record
+   {
+      enum kind_type : uint8_t
+      {
+         created,          ///< created in this state, undone by removing it
+         created_removed,  ///< created and removed again in this state, only the next id is restored
+         modified,         ///< old_value holds the value before the first modification
+         removed           ///< old_value holds the value before the first change, undone by inserting it
+      };
+
+      static const uint32_t npos = uint32_t(-1);
+
+      kind_type      kind;
+      object_id_type id;
+      object*        old_value = nullptr;
+      /// position of the previous record of the same object in the state, or npos
+      uint32_t       prev = npos;
+   };
+
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> > old_values;
-      unordered_map<object_id_type, object_id_type>      old_index_next_ids;
-      std::unordered_set<object_id_type>                 new_ids;
-      unordered_map<object_id_type, unique_ptr<object> > removed;
+      /// records in the order the objects were first changed, each phase of undoing them goes through them in reverse
+      vector<undo_record>                           records;
+      /// position of the latest record of each changed object in records
+      unordered_map<object_id_type, uint32_t>       record_of;
+      /// storage of the old values referenced by records
+      undo_arena                                    arena;
+      /// position of the first record made after the innermost active savepoint, 0 if there is none
+      uint32_t                                      savepoint_begin = 0;
+   };
+
+   /**
+    * The state the objects changed by the newest undo states were in before the first of them, which is the state
+    * undoing them would restore. The old values are owned by the undo states, so an image is only valid until the
+    * undo database changes.
+    */
+   struct undo_image
+   {
+      struct index_changes
+      {
+         /// the value of every changed object before the states, nullptr if it did not exist yet
+         unordered_map<object_id_type, const object*>  old_values;
+         /// the next id of the index before the states, if they created objects in it
+         fc::optional<object_id_type>                  next_id;
+      };
+
+      /** @return the changes made to the index of the given space and type, nullptr if it was not changed */
+      const index_changes* changes_of( uint8_t space_id, uint8_t type_id )const
+      {
+         auto itr = indexes.find( std::make_pair( space_id, type_id ) );
+         return itr == indexes.end() ? nullptr : &itr->second;
+      }
+
+      std::map< std::pair<uint8_t, uint8_t>, index_changes > indexes;
    };
 
 
@@ -91,11 +207,76 @@ namespace graphene { namespace db {
                bool _disable_on_exit = false;
          };
 
+         /**
+          * @class savepoint
+          * @brief A marker into the records of the head undo state
+          *
+          * Unlike a nested session, a savepoint does not start a new undo state. Changes made while it is active
+          * are appended to the head state, and only objects whose latest record predates the savepoint get a new
+          * one. Undoing rolls back the records made after the marker, committing simply drops the marker. Both are
+          * O(1) apart from the records being undone, so the savepoint is the cheap alternative to a nested session
+          * that is merged on success.
+          *
+          * Savepoints must be committed or undone in LIFO order, while the state they were taken in is still the
+          * head of the undo stack.
+          */
+         class savepoint
+         {
+            public:
+               savepoint( savepoint&& mv )
+               :_db(mv._db),_state(mv._state),_position(mv._position),_outer_begin(mv._outer_begin),
+                _arena_mark(mv._arena_mark),_active(mv._active)
+               {
+                  mv._active = false;
+               }
+               ~savepoint() {
+                  try {
+                     if( _active ) _db.rollback( *this );
+                  }
+                  catch ( const fc::exception& e )
+                  {
+                     elog( "${e}", ("e",e.to_detail_string() ) );
+                     throw; // maybe crash..
+                  }
+               }
+               void commit() { if( _active ) _db.release( *this ); _active = false; }
+               void undo()   { if( _active ) _db.rollback( *this ); _active = false; }
+
+               savepoint& operator = ( savepoint&& mv )
+               { try {
+                  if( this == &mv ) return *this;
+                  if( _active ) _db.rollback( *this );
+                  _state       = mv._state;
+                  _position    = mv._position;
+                  _outer_begin = mv._outer_begin;
+                  _arena_mark  = mv._arena_mark;
+                  _active      = mv._active;
+                  mv._active = false;
+                  return *this;
+               } FC_CAPTURE_AND_RETHROW() }
+
+            private:
+               friend class undo_database;
+               savepoint( undo_database& db ):_db(db) {}
+               undo_database&        _db;
+               const undo_state*     _state = nullptr;
+               uint32_t              _position = 0;
+               uint32_t              _outer_begin = 0;
+               undo_arena::mark_type _arena_mark;
+               bool                  _active = false;
+         };
+
          void    disable();
          void    enable();
          bool    enabled()const { return !_disabled; }
 
          session start_undo_session( bool force_enable = false );
+
+         /**
+          * Marks the current end of the head undo state, which requires an active session.
+          * When the undo database is disabled the returned savepoint does nothing.
+          */
+         savepoint start_savepoint();
          /**
           * This should be called just after an object is created
           */
@@ -105,9 +286,9 @@ namespace graphene { namespace db {
           *
           * If it's a new object as of this undo state, its pre-modification value is not stored, because prior to this
           * undo state, it did not exist. Any modifications in this undo state are irrelevant, as the object will simply
-          * be removed if we undo.
+          * be removed if we undo. The same holds for an object already recorded since the innermost savepoint.
           */
-         void on_modify( const object& obj );
+         void on_modify( const object& obj, undo_copy_function copy );
          /**
           * This should be called just before an object is removed.
           *
@@ -116,7 +297,7 @@ namespace graphene { namespace db {
           * Instead, remove it from the list of newly created objects (which must be deleted if we undo), as we don't
           * want to re-delete it if this state is undone.
           */
-         void on_remove( const object& obj );
+         void on_remove( const object& obj, undo_copy_function copy );
 
          /**
           *  Removes the last committed session,
@@ -132,10 +313,16 @@ namespace graphene { namespace db {
 
          const undo_state& head()const;
 
+         /** @return the image of the state before the newest undo states, states must not exceed size() */
+         undo_image image_before( size_t states )const;
+
       private:
          void undo();
          void merge();
          void commit();
+         void undo_changes( undo_state& state, uint32_t begin = 0 );
+         void rollback( savepoint& sp );
+         void release( savepoint& sp );
 
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
@@ -26,8 +26,8 @@
 #include <graphene/db/object_database.hpp>
 
 namespace graphene { namespace db {
-   void base_primary_index::save_undo( const object& obj )
-   { _db.save_undo( obj ); }
+   void base_primary_index::save_undo( const object& obj, undo_copy_function copy )
+   { _db.save_undo( obj, copy ); }
 
    void base_primary_index::on_add( const object& obj )
    {
@@ -35,8 +35,8 @@ namespace graphene { namespace db {
       for( auto ob : _observers ) ob->on_add( obj );
    }
 
-   void base_primary_index::on_remove( const object& obj )
-   { _db.save_undo_remove( obj ); for( auto ob : _observers ) ob->on_remove( obj ); }
+   void base_primary_index::on_remove( const object& obj, undo_copy_function copy )
+   { _db.save_undo_remove( obj, copy ); for( auto ob : _observers ) ob->on_remove( obj ); }
 
    void base_primary_index::on_modify( const object& obj )
    {for( auto ob : _observers ) ob->on_modify(  obj ); }
@@ -27,8 +27,67 @@
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <thread>
+
 namespace graphene { namespace db {
 
+namespace {
+
+   /** Runs task( i ) for every i below count, spread across the available cores */
+   void for_each_parallel( size_t count, const std::function<void(size_t)>& task )
+   {
+      std::atomic<size_t> next( 0 );
+      const size_t workers = std::min<size_t>( std::max( 1u, std::thread::hardware_concurrency() ), count );
+      vector< std::future<void> > done;
+      done.reserve( workers );
+      for( size_t i = 0; i < workers; ++i )
+         done.push_back( std::async( std::launch::async, [&]() {
+            for( size_t n = next++; n < count; n = next++ )
+               task( n );
+         } ) );
+      for( auto& d : done )
+         d.get();
+   }
+
+   /**
+    * Runs task for every (index, file) pair, spread across the available cores. Indexes do not
+    * share any state, so each of them may be loaded or saved independently of the others.
+    */
+   void for_each_index_parallel( const vector< std::pair<index*, fc::path> >& indexes,
+                                 const std::function<void(index&, const fc::path&)>& task )
+   {
+      for_each_parallel( indexes.size(), [&]( size_t n ) { task( *indexes[n].first, indexes[n].second ); } );
+   }
+
+   /** Hard links an unchanged index file into a new directory, copying it where links are not supported */
+   void link_or_copy( const fc::path& from, const fc::path& to )
+   {
+      boost::system::error_code ec;
+      boost::filesystem::create_hard_link( boost::filesystem::path( from.generic_string() ),
+                                           boost::filesystem::path( to.generic_string() ), ec );
+      if( ec )
+         fc::copy( from, to );
+   }
+
+   /** Replaces the object database in data_dir by the completed one in object_database.tmp */
+   void replace_object_database( const fc::path& data_dir )
+   {
+      fc::remove_all( data_dir / "object_database.tmp" / "lock" );
+      if( fc::exists( data_dir / "object_database" ) )
+         fc::rename( data_dir / "object_database", data_dir / "object_database.old" );
+      fc::rename( data_dir / "object_database.tmp", data_dir / "object_database" );
+      fc::remove_all( data_dir / "object_database.old" );
+   }
+
+}
+
 object_database::object_database()
 :_undo_db(*this)
 {
@@ -36,10 +95,15 @@ object_database::object_database()
    _undo_db.enable();
 }
 
-object_database::~object_database(){}
+object_database::~object_database()
+{
+   if( _flush_writer.valid() )
+      _flush_writer.wait();
+}
 
 void object_database::close()
 {
+   wait_for_flush();
 }
 
 const object* object_database::find_object( object_id_type id )const
@@ -71,20 +135,148 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
-   fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+   wait_for_flush();
+   const fc::path current = _data_dir / "object_database";
+   const fc::path next = _data_dir / "object_database.tmp";
+   fc::remove_all( next );
+   fc::create_directories( next / "lock" );
+
+   // Only the indexes changed since they were last opened or saved are written, the files of the others are
+   // carried over into the new directory.
+   const bool current_valid = !_flush_failed && fc::exists( current ) && !fc::exists( current / "lock" );
+   vector< std::pair<index*, fc::path> > dirty;
+   for( uint32_t space = 0; space < _index.size(); ++space )
+   {
+      fc::create_directories( next / fc::to_string(space) );
+      const auto types = _index[space].size();
+      for( uint32_t type = 0; type  <  types; ++type )
+      {
+         if( !_index[space][type] )
+            continue;
+         const fc::path file = fc::path( fc::to_string(space) ) / fc::to_string(type);
+         if( _index[space][type]->is_dirty() || !current_valid || !fc::exists( current / file ) )
+            dirty.emplace_back( _index[space][type].get(), next / file );
+         else
+            link_or_copy( current / file, next / file );
+      }
+   }
+   for_each_index_parallel( dirty, []( index& idx, const fc::path& file ) { idx.save( file ); } );
+   replace_object_database( _data_dir );
+
+   for( const auto& item : dirty )
+      item.first->set_clean();
+   _flush_failed = false;
+}
+
+bool object_database::flush_async( size_t undo_states )
+{
+   if( _flush_writer.valid() && _flush_writer.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+      return false;
+   wait_for_flush();
+
+   // As in flush(), the files of the indexes unchanged since they were last saved are carried over. An index
+   // changed by the undo states left out differs from its file, so it is packed and stays dirty.
+   const fc::path current = _data_dir / "object_database";
+   const bool current_valid = !_flush_failed && fc::exists( current ) && !fc::exists( current / "lock" );
+   const undo_image image = _undo_db.image_before( undo_states );
+   vector<index*> indexes;
+   auto packed = std::make_shared<packed_indexes>();
+   auto unchanged = std::make_shared< vector<fc::path> >();
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type  < _index[space].size(); ++type )
+      {
+         index* idx = _index[space][type].get();
+         if( idx == nullptr )
+            continue;
+         const fc::path file = fc::path( fc::to_string(space) ) / fc::to_string(type);
+         const bool changed = idx->is_dirty() || image.changes_of( space, type ) != nullptr;
+         if( current_valid && !changed && fc::exists( current / file ) )
+            unchanged->push_back( file );
+         else
+         {
+            indexes.push_back( idx );
+            packed->emplace_back( file, vector<char>() );
+         }
+      }
+   for_each_parallel( indexes.size(), [&]( size_t n ) { indexes[n]->pack( image, (*packed)[n].second ); } );
+   for( index* idx : indexes )
+      if( image.changes_of( idx->object_space_id(), idx->object_type_id() ) == nullptr )
+         idx->set_clean();
+
+   const fc::path data_dir = _data_dir;
+   _flush_writer = std::async( std::launch::async, [this, data_dir, packed, unchanged]() {
+      try
+      {
+         const fc::path next = data_dir / "object_database.tmp";
+         fc::remove_all( next );
+         fc::create_directories( next / "lock" );
+         for( const fc::path& file : *unchanged )
+         {
+            fc::create_directories( ( next / file ).parent_path() );
+            link_or_copy( data_dir / "object_database" / file, next / file );
+         }
+         write_indexes( *packed, next );
+         replace_object_database( data_dir );
+         _flush_failed = false;
+      }
+      catch( const fc::exception& e )
+      {
+         // the indexes packed have been marked clean, the next flush has to write all of them
+         elog( "Failed to flush the object database: ${e}", ("e", e.to_detail_string()) );
+         _flush_failed = true;
+      }
+   } );
+   return true;
+}
+
+void object_database::wait_for_flush()
+{
+   if( _flush_writer.valid() )
+      _flush_writer.get();
+}
+
+void object_database::save_indexes( const fc::path& dir )
+{
+   vector< std::pair<index*, fc::path> > indexes;
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
-      fc::create_directories( _data_dir / "object_database.tmp" / fc::to_string(space) );
+      fc::create_directories( dir / fc::to_string(space) );
       const auto types = _index[space].size();
       for( uint32_t type = 0; type  <  types; ++type )
          if( _index[space][type] )
-            _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
+            indexes.emplace_back( _index[space][type].get(), dir / fc::to_string(space)/fc::to_string(type) );
+   }
+   for_each_index_parallel( indexes, []( index& idx, const fc::path& file ) { idx.save( file ); } );
+}
+
+object_database::packed_indexes object_database::pack_indexes( size_t undo_states )const
+{
+   const undo_image image = _undo_db.image_before( undo_states );
+   vector<const index*> indexes;
+   packed_indexes result;
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type  < _index[space].size(); ++type )
+         if( _index[space][type] )
+         {
+            indexes.push_back( _index[space][type].get() );
+            result.emplace_back( fc::path( fc::to_string(space) ) / fc::to_string(type), vector<char>() );
+         }
+   for_each_parallel( indexes.size(), [&]( size_t n ) { indexes[n]->pack( image, result[n].second ); } );
+   return result;
+}
+
+void object_database::write_indexes( const packed_indexes& indexes, const fc::path& dir )
+{
+   for( const auto& item : indexes )
+   {
+      const fc::path file = dir / item.first;
+      fc::create_directories( file.parent_path() );
+      std::ofstream out( file.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+      FC_ASSERT( out, "Unable to write ${f}", ("f", file) );
+      out.write( item.second.data(), item.second.size() );
+      out.close();
+      FC_ASSERT( out, "Unable to write ${f}", ("f", file) );
    }
-   fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
-   if( fc::exists( _data_dir / "object_database" ) )
-      fc::rename( _data_dir / "object_database", _data_dir / "object_database.old" );
-   fc::rename( _data_dir / "object_database.tmp", _data_dir / "object_database" );
-   fc::remove_all( _data_dir / "object_database.old" );
 }
 
 void object_database::wipe(const fc::path& data_dir)
@@ -104,10 +296,12 @@ void object_database::open(const fc::path& data_dir)
        return;
    }
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+   vector< std::pair<index*, fc::path> > indexes;
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
-            _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+            indexes.emplace_back( _index[space][type].get(), _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+   for_each_index_parallel( indexes, []( index& idx, const fc::path& file ) { idx.open( file ); } );
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -118,9 +312,9 @@ void object_database::pop_undo()
    _undo_db.pop_commit();
 } FC_CAPTURE_AND_RETHROW() }
 
-void object_database::save_undo( const object& obj )
+void object_database::save_undo( const object& obj, undo_copy_function copy )
 {
-   _undo_db.on_modify( obj );
+   _undo_db.on_modify( obj, copy );
 }
 
 void object_database::save_undo_add( const object& obj )
@@ -128,9 +322,9 @@ void object_database::save_undo_add( const object& obj )
    _undo_db.on_create( obj );
 }
 
-void object_database::save_undo_remove(const object& obj)
+void object_database::save_undo_remove( const object& obj, undo_copy_function copy )
 {
-   _undo_db.on_remove( obj );
+   _undo_db.on_remove( obj, copy );
 }
 
 } } // namespace graphene::db
@@ -24,9 +24,71 @@
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
+#include <algorithm>
 
 namespace graphene { namespace db {
 
+/// Old values are bump allocated from blocks of this size, larger objects get a block of their own
+static const size_t undo_arena_block_size = 64 * 1024;
+
+void* undo_arena::allocate( size_t size, size_t align )
+{
+   char* p = (char*)( ( uintptr_t(_pos) + align - 1 ) & ~uintptr_t( align - 1 ) );
+   if( _pos == nullptr || p + size > _end )
+   {
+      const size_t block_size = std::max( undo_arena_block_size, size + align );
+      _blocks.emplace_back( new char[block_size] );
+      _pos = _blocks.back().get();
+      _end = _pos + block_size;
+      p = (char*)( ( uintptr_t(_pos) + align - 1 ) & ~uintptr_t( align - 1 ) );
+   }
+   _pos = p + size;
+   return p;
+}
+
+void undo_arena::splice( undo_arena& other )
+{
+   if( _objects.empty() && _blocks.empty() )
+   {
+      _blocks  = std::move( other._blocks );
+      _objects = std::move( other._objects );
+      _pos = other._pos;
+      _end = other._end;
+   }
+   else
+   {
+      // keep allocating from our own current block, the spliced ones are only kept alive
+      _blocks.reserve( _blocks.size() + other._blocks.size() );
+      for( auto& block : other._blocks )
+         _blocks.push_back( std::move( block ) );
+      _objects.insert( _objects.end(), other._objects.begin(), other._objects.end() );
+   }
+   other._blocks.clear();
+   other._objects.clear();
+   other._pos = nullptr;
+   other._end = nullptr;
+}
+
+void undo_arena::clear()
+{
+   for( object* obj : _objects )
+      obj->~object();
+   _objects.clear();
+   _blocks.clear();
+   _pos = nullptr;
+   _end = nullptr;
+}
+
+void undo_arena::rewind( const mark_type& m )
+{
+   for( size_t i = m.objects; i < _objects.size(); ++i )
+      _objects[i]->~object();
+   _objects.resize( m.objects );
+   _blocks.resize( m.blocks );
+   _pos = m.pos;
+   _end = m.end;
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
@@ -44,6 +106,53 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
    ++_active_sessions;
    return session(*this, disable_on_exit );
 }
+undo_database::savepoint undo_database::start_savepoint()
+{
+   savepoint result( *this );
+   if( _disabled ) return result;
+   FC_ASSERT( _active_sessions > 0 && !_stack.empty(), "A savepoint requires an active undo session" );
+
+   undo_state& state = _stack.back();
+   result._state       = &state;
+   result._position    = state.records.size();
+   result._outer_begin = state.savepoint_begin;
+   result._arena_mark  = state.arena.mark();
+   result._active      = true;
+   state.savepoint_begin = state.records.size();
+   return result;
+}
+
+void undo_database::rollback( savepoint& sp )
+{ try {
+   FC_ASSERT( !_stack.empty() && &_stack.back() == sp._state, "Savepoint does not belong to the head undo state" );
+   undo_state& state = _stack.back();
+   FC_ASSERT( state.savepoint_begin == sp._position, "Savepoints must be undone in reverse order" );
+
+   disable();
+   undo_changes( state, sp._position );
+   enable();
+
+   for( uint32_t i = state.records.size(); i > sp._position; --i )
+   {
+      const undo_record& record = state.records[i-1];
+      if( record.prev == undo_record::npos )
+         state.record_of.erase( record.id );
+      else
+         state.record_of[record.id] = record.prev;
+   }
+   state.records.resize( sp._position );
+   state.arena.rewind( sp._arena_mark );
+   state.savepoint_begin = sp._outer_begin;
+} FC_CAPTURE_AND_RETHROW() }
+
+void undo_database::release( savepoint& sp )
+{
+   FC_ASSERT( !_stack.empty() && &_stack.back() == sp._state, "Savepoint does not belong to the head undo state" );
+   undo_state& state = _stack.back();
+   FC_ASSERT( state.savepoint_begin == sp._position, "Savepoints must be committed in reverse order" );
+   state.savepoint_begin = sp._outer_begin;
+}
+
 void undo_database::on_create( const object& obj )
 {
    if( _disabled ) return;
@@ -51,45 +160,95 @@ void undo_database::on_create( const object& obj )
    if( _stack.empty() )
       _stack.emplace_back();
    auto& state = _stack.back();
-   auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
-   auto itr = state.old_index_next_ids.find( index_id );
-   if( itr == state.old_index_next_ids.end() )
-      state.old_index_next_ids[index_id] = obj.id;
-   state.new_ids.insert(obj.id);
+   state.record_of[obj.id] = state.records.size();
+   state.records.push_back( undo_record{ undo_record::created, obj.id, nullptr, undo_record::npos } );
 }
-void undo_database::on_modify( const object& obj )
+void undo_database::on_modify( const object& obj, undo_copy_function copy )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
       _stack.emplace_back();
    auto& state = _stack.back();
-   if( state.new_ids.find(obj.id) != state.new_ids.end() )
-      return;
-   auto itr =  state.old_values.find(obj.id);
-   if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   auto itr = state.record_of.find(obj.id);
+   uint32_t prev = undo_record::npos;
+   if( itr != state.record_of.end() )
+   {
+      // new or already modified since the innermost savepoint, the record already describes how to undo it
+      if( itr->second >= state.savepoint_begin )
+         return;
+      prev = itr->second;
+      itr->second = state.records.size();
+   }
+   else
+      state.record_of.emplace( obj.id, state.records.size() );
+   state.records.push_back( undo_record{ undo_record::modified, obj.id, copy( state.arena, obj ), prev } );
 }
-void undo_database::on_remove( const object& obj )
+void undo_database::on_remove( const object& obj, undo_copy_function copy )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
       _stack.emplace_back();
    undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) )
+   auto itr = state.record_of.find(obj.id);
+   uint32_t prev = undo_record::npos;
+   if( itr != state.record_of.end() )
    {
-      state.new_ids.erase(obj.id);
-      return;
+      if( itr->second >= state.savepoint_begin )
+      {
+         undo_record& record = state.records[itr->second];
+         if( record.kind == undo_record::created )
+            record.kind = undo_record::created_removed;
+         else if( record.kind == undo_record::modified )
+            record.kind = undo_record::removed;
+         return;
+      }
+      prev = itr->second;
+      itr->second = state.records.size();
    }
-   if( state.old_values.count(obj.id) )
+   else
+      state.record_of.emplace( obj.id, state.records.size() );
+   state.records.push_back( undo_record{ undo_record::removed, obj.id, copy( state.arena, obj ), prev } );
+}
+
+void undo_database::undo_changes( undo_state& state, uint32_t begin )
+{
+   // After a savepoint an object can have several records in the state. Its first record since begin tells what it
+   // was before the changes, its latest record whether it exists now.
+   struct change
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
-      state.old_values.erase(obj.id);
-      return;
+      const undo_record* first;
+      bool               existed;
+      bool               exists;
+   };
+   vector<change> changes;
+   changes.reserve( state.records.size() - begin );
+   for( uint32_t i = state.records.size(); i > begin; --i )
+   {
+      const undo_record& record = state.records[i-1];
+      if( record.prev != undo_record::npos && record.prev >= begin )
+         continue;
+      const auto latest = state.records[ state.record_of.at( record.id ) ].kind;
+      changes.push_back( change{ &record,
+                                 record.kind == undo_record::modified || record.kind == undo_record::removed,
+                                 latest == undo_record::created || latest == undo_record::modified } );
    }
-   if( state.removed.count(obj.id) ) return;
-   state.removed[obj.id] = obj.clone();
+
+   // The old values are restored first, then the new objects are removed, the next ids restored and the removed
+   // objects inserted again. Each phase goes through the changes in reverse order.
+   for( const change& c : changes )
+      if( c.existed && c.exists )
+         _db.modify( _db.get_object( c.first->id ), [&]( object& obj ){ obj.move_from( *c.first->old_value ); } );
+   for( const change& c : changes )
+      if( !c.existed && c.exists )
+         _db.remove( _db.get_object( c.first->id ) );
+   for( const change& c : changes )
+      if( !c.existed )
+         _db.get_mutable_index( c.first->id.space(), c.first->id.type() ).set_next_id( c.first->id );
+   for( const change& c : changes )
+      if( c.existed && !c.exists )
+         _db.insert( std::move( *c.first->old_value ) );
 }
 
 void undo_database::undo()
@@ -98,24 +257,7 @@ void undo_database::undo()
    FC_ASSERT( _active_sessions > 0 );
    disable();
 
-   auto& state = _stack.back();
-   for( auto& item : state.old_values )
-   {
-      _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-   }
-
-   for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-   {
-      _db.remove( _db.get_object(*ritr) );
-   }
-
-   for( auto& item : state.old_index_next_ids )
-   {
-      _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-   }
-
-   for( auto& item : state.removed )
-      _db.insert( std::move(*item.second) );
+   undo_changes( _stack.back() );
 
    _stack.pop_back();
    enable();
@@ -136,10 +278,10 @@ void undo_database::merge()
    auto& prev_state = _stack[_stack.size()-2];
 
    // An object's relationship to a state can be:
-   // in new_ids            : new
-   // in old_values (was=X) : upd(was=X)
-   // in removed (was=X)    : del(was=X)
-   // not in any of above   : nop
+   // created record             : new
+   // modified record (was=X)    : upd(was=X)
+   // removed record (was=X)     : del(was=X)
+   // created_removed or no record : nop
    //
    // When merging A=prev_state and B=state we have a 4x4 matrix of all possibilities:
    //
@@ -169,75 +311,43 @@ void undo_database::merge()
    // state A and B.
    //
    // Type A (and AB) can be implemented as a no-op; prev_state already contains the correct value for the merged state.
-   // Type B (and AB) can be implemented by copying from state to prev_state.
+   // Type B (and AB) can be implemented by appending the record of state to prev_state. The old value it points to
+   // stays where it is, as the arena of state is spliced into the arena of prev_state as a whole.
    // Type C needs special case-by-case logic.
    // Type N/A can be ignored or assert(false) as it can only occur if prev_state and state have illegal values
    // (a serious logic error which should never happen).
-   //
-
-   // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
 
-   // *+upd
-   for( auto& obj : state.old_values )
+   prev_state.arena.splice( state.arena );
+   prev_state.records.reserve( prev_state.records.size() + state.records.size() );
+   for( undo_record record : state.records )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      auto itr = prev_state.record_of.find( record.id );
+      if( itr == prev_state.record_of.end() || itr->second < prev_state.savepoint_begin )
       {
-         // new+upd -> new, type A
+         // nop+*, type B. A record older than the savepoint of prev_state counts as nop, it has to stay intact
+         // for the savepoint to be undone.
+         if( itr == prev_state.record_of.end() )
+         {
+            record.prev = undo_record::npos;
+            prev_state.record_of.emplace( record.id, prev_state.records.size() );
+         }
+         else
+         {
+            record.prev = itr->second;
+            itr->second = prev_state.records.size();
+         }
+         prev_state.records.push_back( record );
          continue;
       }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      undo_record& prev_record = prev_state.records[itr->second];
+      if( record.kind == undo_record::removed )
       {
-         // upd(was=X) + upd(was=Y) -> upd(was=X), type A
-         continue;
+         // new+del -> nop, upd(was=X)+del(was=Y) -> del(was=X), type C
+         assert( prev_record.kind == undo_record::created || prev_record.kind == undo_record::modified );
+         prev_record.kind = ( prev_record.kind == undo_record::created ) ? undo_record::created_removed
+                                                                         : undo_record::removed;
       }
-      // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
-      // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
-   }
-
-   // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-   for( auto id : state.new_ids )
-      prev_state.new_ids.insert(id);
-
-   // old_index_next_ids can only be updated, iterate over *+upd cases
-   for( auto& item : state.old_index_next_ids )
-   {
-      if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
-      {
-         // nop+upd(was=Y) -> upd(was=Y), type B
-         prev_state.old_index_next_ids[item.first] = item.second;
-         continue;
-      }
-      else
-      {
-         // upd(was=X)+upd(was=Y) -> upd(was=X), type A
-         // type A implementation is a no-op, as discussed above, so there is no code here
-         continue;
-      }
-   }
-
-   // *+del
-   for( auto& obj : state.removed )
-   {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
-      {
-         // new + del -> nop (type C)
-         prev_state.new_ids.erase(obj.second->id);
-         continue;
-      }
-      auto it = prev_state.old_values.find(obj.second->id);
-      if( it != prev_state.old_values.end() )
-      {
-         // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
-         prev_state.old_values.erase(obj.second->id);
-         continue;
-      }
-      // del + del -> N/A
-      assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
-      // nop + del(was=Y) -> del(was=Y)
-      prev_state.removed[obj.second->id] = std::move(obj.second);
+      // new+upd -> new, upd(was=X)+upd(was=Y) -> upd(was=X), type A
    }
    _stack.pop_back();
    --_active_sessions;
@@ -255,25 +365,7 @@ void undo_database::pop_commit()
 
    disable();
    try {
-      auto& state = _stack.back();
-
-      for( auto& item : state.old_values )
-      {
-         _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-      }
-
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-      {
-         _db.remove( _db.get_object(*ritr) );
-      }
-
-      for( auto& item : state.old_index_next_ids )
-      {
-         _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-      }
-
-      for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
+      undo_changes( _stack.back() );
 
       _stack.pop_back();
    }
@@ -291,4 +383,24 @@ const undo_state& undo_database::head()const
    return _stack.back();
 }
 
+undo_image undo_database::image_before( size_t states )const
+{
+   FC_ASSERT( states <= _stack.size(), "Not enough undo history", ("states",states)("size",_stack.size()) );
+   undo_image result;
+   // The first record of an object in the oldest state changing it describes the object before all of the states,
+   // and the first object created in an index got the next id the index had before them.
+   for( auto itr = _stack.end() - states; itr != _stack.end(); ++itr )
+   {
+      for( const undo_record& record : itr->records )
+      {
+         auto& changes = result.indexes[ std::make_pair( record.id.space(), record.id.type() ) ];
+         const bool existed = record.kind == undo_record::modified || record.kind == undo_record::removed;
+         changes.old_values.emplace( record.id, existed ? record.old_value : nullptr );
+         if( !existed && !changes.next_id.valid() )
+            changes.next_id = record.id;
+      }
+   }
+   return result;
+}
+
 } } // graphene::db
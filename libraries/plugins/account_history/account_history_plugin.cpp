@@ -57,6 +57,15 @@ class account_history_plugin_impl
        */
       void update_account_histories( const signed_block& b );
 
+      /// Moves the oldest irreversible entries of the account beyond the newest _max_ops_per_account to the cold store.
+      void prune_account( account_id_type account, uint32_t last_irreversible_block );
+      /// Moves the irreversible entries of operations older than cutoff to the cold store.
+      void prune_expired( fc::time_point_sec cutoff, uint32_t last_irreversible_block );
+      /// The operation of the entry is removed from memory along with the last entry referring to it.
+      void move_to_cold_store( const account_transaction_history_object& entry );
+
+      bool keeps_all_history()const { return _max_ops_per_account == 0 && _retention_seconds == 0; }
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -64,6 +73,12 @@ class account_history_plugin_impl
 
       account_history_plugin& _self;
       flat_set<account_id_type> _tracked_accounts;
+
+      uint32_t _max_ops_per_account = 0;
+      uint32_t _retention_seconds = 0;
+      /// operations before this one are known not to have expired entries left in memory
+      operation_history_id_type _next_to_expire;
+      cold_history_store _cold_store;
 };
 
 account_history_plugin_impl::~account_history_plugin_impl()
@@ -111,6 +126,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
    }
 
    // create real non virtual operation and update account history object index
+   flat_set<account_id_type> updated_accounts;
    for( const optional< operation_history_object >& o_op : hist )
    {
       auto oho_valid_pair = helper_func_for_creating_operation_history_object(o_op);
@@ -149,12 +165,14 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                 obj.operation_id = oho_valid_pair.first.id;
                 obj.account = account_id;
                 obj.sequence = stats_obj.total_ops+1;
+                obj.op_type = op.op.which();
                 obj.next = stats_obj.most_recent_op;
             });
             db.modify( stats_obj, [&]( account_statistics_object& obj ){
                 obj.most_recent_op = ath.id;
                 obj.total_ops = ath.sequence;
             });
+            updated_accounts.insert( account_id );
          }
       }
       else
@@ -167,15 +185,81 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                const auto& stats_obj = account_id(db).statistics(db);
                const auto& ath = db.create<account_transaction_history_object>( [&]( account_transaction_history_object& obj ){
                    obj.operation_id = oho_valid_pair.first.id;
+                   obj.account = account_id;
+                   obj.sequence = stats_obj.total_ops+1;
+                   obj.op_type = op.op.which();
                    obj.next = stats_obj.most_recent_op;
                });
                db.modify( stats_obj, [&]( account_statistics_object& obj ){
                    obj.most_recent_op = ath.id;
+                   obj.total_ops = ath.sequence;
                });
+               updated_accounts.insert( account_id );
             }
          }
       }
    }
+
+   if( keeps_all_history() )
+      return;
+
+   // Only irreversible entries leave memory: the cold store is append only, it never has to forget an entry of a popped block.
+   const uint32_t last_irreversible_block = db.get_dynamic_global_properties().last_irreversible_block_num;
+   if( _max_ops_per_account > 0 )
+      for( auto account_id : updated_accounts )
+         prune_account( account_id, last_irreversible_block );
+   if( _retention_seconds > 0 )
+      prune_expired( b.timestamp - _retention_seconds, last_irreversible_block );
+}
+
+void account_history_plugin_impl::prune_account( account_id_type account, uint32_t last_irreversible_block )
+{
+   graphene::chain::database& db = database();
+   const uint32_t total_ops = account(db).statistics(db).total_ops;
+   const auto& by_seq_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_seq>();
+
+   auto itr = by_seq_idx.lower_bound( boost::make_tuple( account ) );
+   while( itr != by_seq_idx.end() && itr->account == account
+          && total_ops - itr->sequence >= _max_ops_per_account
+          && itr->operation_id(db).block_num <= last_irreversible_block )
+   {
+      const account_transaction_history_object& entry = *itr++;
+      move_to_cold_store( entry );
+   }
+}
+
+void account_history_plugin_impl::prune_expired( fc::time_point_sec cutoff, uint32_t last_irreversible_block )
+{
+   graphene::chain::database& db = database();
+   const auto& by_id_idx = db.get_index_type<operation_history_index>().indices().get<by_id>();
+   const auto& by_opid_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_opid>();
+
+   auto itr = by_id_idx.lower_bound( _next_to_expire );
+   while( itr != by_id_idx.end() && itr->block_timestamp < cutoff && itr->block_num <= last_irreversible_block )
+   {
+      // operations without entries, like the virtual operations of a block, stay where they are
+      const operation_history_id_type op_id = itr->id;
+      ++itr;
+      _next_to_expire = op_id + 1;
+
+      auto entries = by_opid_idx.equal_range( op_id );
+      while( entries.first != entries.second )
+         move_to_cold_store( *entries.first++ );
+   }
+}
+
+void account_history_plugin_impl::move_to_cold_store( const account_transaction_history_object& entry )
+{
+   graphene::chain::database& db = database();
+   const operation_history_id_type op_id = entry.operation_id;
+   const operation_history_object& op = op_id(db);
+
+   _cold_store.append( entry, op );
+   db.remove( entry );
+
+   const auto& by_opid_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_opid>();
+   if( by_opid_idx.find( op_id ) == by_opid_idx.end() )
+      db.remove( op );
 }
 } // end namespace detail
 
@@ -205,6 +289,8 @@ void account_history_plugin::plugin_set_program_options(
 {
    cli.add_options()
          ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
+         ("max-ops-per-account", boost::program_options::value<uint32_t>(), "Number of the most recent operations of every account kept in memory, older ones are moved to the cold history store (0 keeps all)")
+         ("history-retention-days", boost::program_options::value<uint32_t>(), "Number of days of account history kept in memory, older operations are moved to the cold history store (0 keeps all)")
          ;
    cfg.add(cli);
 }
@@ -212,19 +298,43 @@ void account_history_plugin::plugin_set_program_options(
 void account_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
+   // The object database drops the entries moved to the cold store, they have to be on disk before it is:
+   database().flushing.connect( [&](){ my->_cold_store.flush(); } );
    database().add_index< primary_index< operation_history_index > >();
    database().add_index< primary_index< account_transaction_history_index > >();
 
    LOAD_VALUE_SET(options, "tracked-accounts", my->_tracked_accounts, graphene::chain::account_id_type);
+
+   if( options.count( "max-ops-per-account" ) )
+      my->_max_ops_per_account = options["max-ops-per-account"].as<uint32_t>();
+   if( options.count( "history-retention-days" ) )
+      my->_retention_seconds = options["history-retention-days"].as<uint32_t>() * 24 * 60 * 60;
+
+   // The store has to be open before the database replays its blocks. It is kept next to the object database, and
+   // opened even without a retention, so that the history moved out by an earlier run remains readable.
+   const fc::path cold_store_dir = app().data_dir() / "blockchain" / "account_history";
+   if( !my->keeps_all_history() || fc::exists( cold_store_dir ) )
+      my->_cold_store.open( cold_store_dir );
 }
 
 void account_history_plugin::plugin_startup()
 {
 }
 
+void account_history_plugin::plugin_shutdown()
+{
+   my->_cold_store.flush();
+   my->_cold_store.close();
+}
+
 flat_set<account_id_type> account_history_plugin::tracked_accounts() const
 {
    return my->_tracked_accounts;
 }
 
+const cold_history_store* account_history_plugin::cold_store() const
+{
+   return my->_cold_store.is_open() ? &my->_cold_store : nullptr;
+}
+
 } }
@@ -0,0 +1,207 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <graphene/account_history/cold_history_store.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <cstring>
+#include <limits>
+
+namespace graphene { namespace account_history {
+
+namespace {
+
+/**
+ *  The fixed size part of a record, followed by the packed operation. The data of a record is written before its
+ *  header, and the file is grown with zeroes, so a zero header marks the end of the store even after a crash.
+ */
+struct record_header
+{
+   uint64_t prev = 0;          ///< offset of the previous record of the account plus one, 0 for its first record
+   uint64_t account = 0;
+   uint64_t operation_id = 0;
+   uint32_t sequence = 0;
+   uint32_t op_type = 0;
+   uint32_t size = 0;          ///< size of the packed operation
+   uint32_t reserved = 0;
+};
+
+const uint64_t chunk_size = 16 * 1024 * 1024;
+
+uint64_t record_size( uint32_t data_size )
+{
+   // keep the headers 8 byte aligned
+   return ( sizeof(record_header) + data_size + 7 ) / 8 * 8;
+}
+
+} // anonymous
+
+cold_history_store::~cold_history_store()
+{
+   try
+   {
+      close();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "${e}", ("e", e.to_detail_string()) );
+   }
+}
+
+void cold_history_store::open( const fc::path& dir )
+{ try {
+   fc::create_directories( dir );
+   _file.open( dir / "history", chunk_size );
+   _size = 0;
+   _accounts.clear();
+
+   const char* data = _file.data();
+   record_header h;
+   while( _size + sizeof(h) <= _file.file_size() )
+   {
+      memcpy( (char*)&h, data + _size, sizeof(h) );
+      if( h.size == 0 || _size + record_size( h.size ) > _file.file_size() )
+         break;
+
+      account_records& a = _accounts[h.account];
+      if( a.newest == 0 )
+         a.oldest_operation = operation_history_id_type( h.operation_id );
+      a.newest = _size + 1;
+      a.newest_sequence = h.sequence;
+      a.newest_operation = operation_history_id_type( h.operation_id );
+      _size += record_size( h.size );
+   }
+   ilog( "Opened cold account history with ${n} bytes of ${a} accounts", ("n", _size)("a", _accounts.size()) );
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+void cold_history_store::flush()
+{
+   if( _file.is_open() )
+      _file.flush();
+}
+
+void cold_history_store::close()
+{
+   if( _file.is_open() )
+      _file.close( _size );
+   _accounts.clear();
+}
+
+void cold_history_store::append( const account_transaction_history_object& entry, const operation_history_object& op )
+{
+   FC_ASSERT( is_open() );
+   account_records& a = _accounts[entry.account.instance.value];
+   if( entry.sequence <= a.newest_sequence )
+      return;
+
+   const vector<char> packed = fc::raw::pack( op );
+   record_header h;
+   h.prev = a.newest;
+   h.account = entry.account.instance.value;
+   h.operation_id = entry.operation_id.instance.value;
+   h.sequence = entry.sequence;
+   h.op_type = entry.op_type;
+   h.size = packed.size();
+
+   _file.reserve( _size + record_size( h.size ) );
+   memcpy( _file.data() + _size + sizeof(h), packed.data(), packed.size() );
+   memcpy( _file.data() + _size, (const char*)&h, sizeof(h) );
+
+   if( a.newest == 0 )
+      a.oldest_operation = entry.operation_id;
+   a.newest = _size + 1;
+   a.newest_sequence = entry.sequence;
+   a.newest_operation = entry.operation_id;
+   _size += record_size( h.size );
+}
+
+uint32_t cold_history_store::newest_sequence( account_id_type account )const
+{
+   auto itr = _accounts.find( account.instance.value );
+   return itr == _accounts.end() ? 0 : itr->second.newest_sequence;
+}
+
+uint32_t cold_history_store::find_sequence( account_id_type account, operation_history_id_type op_id )const
+{
+   auto itr = _accounts.find( account.instance.value );
+   if( itr == _accounts.end() || op_id < itr->second.oldest_operation )
+      return 0;
+   if( !( op_id < itr->second.newest_operation ) )
+      return itr->second.newest_sequence;
+
+   uint32_t result = 0;
+   for_each( account, std::numeric_limits<uint32_t>::max(), [&]( const record& r ) {
+      if( r.operation_id > op_id )
+         return true;
+      result = r.sequence;
+      return false;
+   } );
+   return result;
+}
+
+void cold_history_store::for_each( account_id_type account, uint32_t start,
+                                   const std::function<bool(const record&)>& visitor )const
+{
+   auto itr = _accounts.find( account.instance.value );
+   if( itr == _accounts.end() )
+      return;
+
+   uint64_t next = itr->second.newest;
+   while( next != 0 )
+   {
+      const record r = read_record( next - 1, &next );
+      if( r.sequence <= start && !visitor( r ) )
+         return;
+   }
+}
+
+operation_history_object cold_history_store::load( const record& r )const
+{ try {
+   record_header h;
+   memcpy( (char*)&h, _file.data() + r.offset, sizeof(h) );
+   fc::datastream<const char*> ds( _file.data() + r.offset + sizeof(h), h.size );
+   operation_history_object result;
+   fc::raw::unpack( ds, result );
+   return result;
+} FC_CAPTURE_AND_RETHROW( (r.account)(r.sequence) ) }
+
+cold_history_store::record cold_history_store::read_record( uint64_t offset, uint64_t* prev )const
+{
+   FC_ASSERT( offset + sizeof(record_header) <= _size );
+   record_header h;
+   memcpy( (char*)&h, _file.data() + offset, sizeof(h) );
+
+   record r;
+   r.account = account_id_type( h.account );
+   r.sequence = h.sequence;
+   r.op_type = h.op_type;
+   r.operation_id = operation_history_id_type( h.operation_id );
+   r.offset = offset;
+   if( prev != nullptr )
+      *prev = h.prev;
+   return r;
+}
+
+} } // graphene::account_history
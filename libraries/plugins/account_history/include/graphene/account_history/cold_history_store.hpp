@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <functional>
+#include <unordered_map>
+
+namespace graphene { namespace account_history {
+
+using namespace graphene::chain;
+
+/**
+ *  @class cold_history_store
+ *  @brief Append only, memory mapped store of the account history entries moved out of the object database.
+ *
+ *  Every record holds one account history entry together with a packed copy of its operation. The records of an
+ *  account are chained from its newest to its oldest one, so only the newest record of every account is kept in
+ *  memory. Entries are stored once, in the order of their sequence numbers: appending an entry the store already
+ *  holds is a no-op, which makes replaying the chain over an existing store safe.
+ */
+class cold_history_store
+{
+   public:
+      /// An entry of the store, the operation itself is only unpacked by load().
+      struct record
+      {
+         account_id_type            account;
+         uint32_t                   sequence = 0;
+         uint32_t                   op_type = 0;
+         operation_history_id_type  operation_id;
+         uint64_t                   offset = 0;
+      };
+
+      ~cold_history_store();
+
+      void open( const fc::path& dir );
+      bool is_open()const { return _file.is_open(); }
+      void flush();
+      void close();
+
+      /// Appends the entry unless the store already holds the entry of the account with this sequence number.
+      void append( const account_transaction_history_object& entry, const operation_history_object& op );
+
+      /// @return the sequence number of the newest stored entry of the account, 0 if there is none
+      uint32_t newest_sequence( account_id_type account )const;
+      /// @return the sequence number of the account's newest stored entry with an id not above op_id, 0 if none
+      uint32_t find_sequence( account_id_type account, operation_history_id_type op_id )const;
+
+      /**
+       *  Visits the stored entries of the account with a sequence number not above start, from the newest to the
+       *  oldest, until the visitor returns false.
+       */
+      void for_each( account_id_type account, uint32_t start, const std::function<bool(const record&)>& visitor )const;
+      operation_history_object load( const record& r )const;
+
+   private:
+      struct account_records
+      {
+         uint64_t                   newest = 0;  ///< offset of the newest record plus one
+         uint32_t                   newest_sequence = 0;
+         operation_history_id_type  newest_operation;
+         operation_history_id_type  oldest_operation;
+      };
+
+      record read_record( uint64_t offset, uint64_t* prev = nullptr )const;
+
+      mutable detail::mapped_log_file                 _file;
+      uint64_t                                        _size = 0;
+      std::unordered_map< uint64_t, account_records > _accounts;
+};
+
+} } // graphene::account_history
@@ -1930,6 +1930,16 @@ class wallet_api
        */
       vector<das33_pledge_holder_object> get_das33_pledges_by_account(const string& account) const;
 
+      /**
+       * @brief Return a page of the pledges of specified account.
+       *
+       * @param account         name or id of the account
+       * @param from            id of the first pledge, it is included in the result
+       * @param limit           the number of entries to return (max 100)
+       * @returns               a list of pledge holder objects.
+       */
+      vector<das33_pledge_holder_object> get_das33_pledges_by_account_paged(const string& account, das33_pledge_holder_id_type from, uint32_t limit) const;
+
       /**
        * @brief Return a list of pledges for specified project.
        *
@@ -2314,6 +2324,7 @@ FC_API( graphene::wallet::wallet_api,
         (das33_pledge_asset)
         (get_das33_pledges)
         (get_das33_pledges_by_account)
+        (get_das33_pledges_by_account_paged)
         (get_das33_pledges_by_project)
         (create_das33_project)
         (update_das33_project)
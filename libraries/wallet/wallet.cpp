@@ -5505,6 +5505,12 @@ vector<das33_pledge_holder_object> wallet_api::get_das33_pledges_by_account(cons
    return my->_remote_db->get_das33_pledges_by_account(account_obj.id);
 }
 
+vector<das33_pledge_holder_object> wallet_api::get_das33_pledges_by_account_paged(const string& account, das33_pledge_holder_id_type from, uint32_t limit) const
+{
+   account_object account_obj = my->get_account(account);
+   return my->_remote_db->get_das33_pledges_by_account_paged(account_obj.id, from, limit);
+}
+
 vector<das33_pledge_holder_object> wallet_api::get_das33_pledges_by_project(const string& project, das33_pledge_holder_id_type from, uint32_t limit) const
 {
   das33_project_object project_obj = my->_remote_db->get_das33_projects(project, 1)[0];
@@ -123,7 +123,12 @@ void database_fixture::init_genesis_state()
 }
 
 database_fixture::database_fixture()
-   : app(), db( *app.chain_database() ), _dal(db)
+   : database_fixture( boost::program_options::variables_map() )
+{
+}
+
+database_fixture::database_fixture( const boost::program_options::variables_map& options )
+   : app(), db( *app.chain_database() ), _dal(db), plugin_options( options )
 {
    try {
    int argc = boost::unit_test::framework::master_test_suite().argc;
@@ -142,8 +147,6 @@ database_fixture::database_fixture()
 
    init_genesis_state();
 
-   boost::program_options::variables_map options;
-
    genesis_state.initial_timestamp = time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
 
    genesis_state.initial_active_witnesses = 10;
@@ -160,11 +163,11 @@ database_fixture::database_fixture()
    genesis_state.initial_parameters.current_fees->zero_all_fees();
    open_database();
 
-   // app.initialize();
+   app.initialize( data_dir->path(), plugin_options );
    ahplugin->plugin_set_app(&app);
-   ahplugin->plugin_initialize(options);
+   ahplugin->plugin_initialize(plugin_options);
    mhplugin->plugin_set_app(&app);
-   mhplugin->plugin_initialize(options);
+   mhplugin->plugin_initialize(plugin_options);
 
    ahplugin->plugin_startup();
    mhplugin->plugin_startup();
@@ -290,7 +293,7 @@ void database_fixture::verify_account_history_plugin_index( )const
    {
       /*
       vector< pair< account_id_type, address > > tuples_from_db;
-      const auto& primary_account_idx = db.get_index_type<account_index>().indices().get<by_id>();
+      const auto& primary_account_idx = db.get_index_type<account_index>();
       flat_set< public_key_type > acct_addresses;
       acct_addresses.reserve( 2 * GRAPHENE_DEFAULT_MAX_AUTHORITY_MEMBERSHIP + 2 );
 
@@ -176,12 +176,15 @@ struct database_fixture {
    public_key_type init_account_pub_key;
 
    optional<fc::temp_directory> data_dir;
+   boost::program_options::variables_map plugin_options;
    bool skip_key_index_test = false;
    uint32_t anon_acct_count;
 
    static constexpr uint32_t apply_bonus(uint32_t value, uint32_t bonus);
 
    database_fixture();
+   /// Initializes the plugins with the given options, the data directory of the application is the one of the database
+   explicit database_fixture( const boost::program_options::variables_map& options );
    ~database_fixture();
 
    void init_genesis_state();
@@ -577,6 +577,31 @@ BOOST_AUTO_TEST_CASE( get_queue_submissions_with_pos_for_accounts_unit_test )
 
 } FC_LOG_AND_RETHROW() }*/
 
+BOOST_AUTO_TEST_CASE( get_reward_queue_by_page_unit_test )
+{ try {
+  VAULT_ACTOR(vault)
+
+  for (int i = 0; i < 10; ++i)
+    do_op(submit_reserve_cycles_to_queue_operation(get_cycle_issuer_id(), vault_id, 100 + i, 200, ""));
+
+  // Out of bounds:
+  GRAPHENE_REQUIRE_THROW( _dal.get_reward_queue_by_page(10, 1), fc::exception );
+  GRAPHENE_REQUIRE_THROW( _dal.get_reward_queue_by_page(5, 6), fc::exception );
+
+  // Get 4 elements, starting from 3:
+  const auto& page = _dal.get_reward_queue_by_page(3, 4);
+  BOOST_CHECK_EQUAL( page.size(), 4 );
+  BOOST_CHECK_EQUAL( page[0].amount.value, 103 );
+  BOOST_CHECK_EQUAL( page[3].amount.value, 106 );
+
+  // The page agrees with the positions of the submissions:
+  const auto pos_vec = *_dal.get_queue_submissions_with_pos(vault_id).result;
+  BOOST_CHECK_EQUAL( pos_vec.size(), 10 );
+  BOOST_CHECK_EQUAL( pos_vec[5].position, 5 );
+  BOOST_CHECK_EQUAL( pos_vec[5].submission.amount.value, page[2].amount.value );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( get_block_with_virtual_operations )
 { try {
     ACTOR(alicew);
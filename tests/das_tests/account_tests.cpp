@@ -28,12 +28,58 @@
 #include <graphene/chain/hardfork.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <graphene/app/api.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/cold_history_store.hpp>
+#include <graphene/utilities/tempdir.hpp>
 
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
 using namespace graphene::chain::test;
 
+namespace {
+
+boost::program_options::variables_map history_options( const std::string& name, uint32_t value )
+{
+  boost::program_options::variables_map options;
+  options.emplace( name, boost::program_options::variable_value( value, false ) );
+  return options;
+}
+
+struct max_ops_history_fixture : database_fixture
+{
+  max_ops_history_fixture() : database_fixture( history_options( "max-ops-per-account", 3 ) ) {}
+};
+
+struct retention_history_fixture : database_fixture
+{
+  retention_history_fixture() : database_fixture( history_options( "history-retention-days", 1 ) ) {}
+};
+
+vector<object_id_type> ids_of( const vector<operation_history_object>& ops )
+{
+  vector<object_id_type> result;
+  for ( const auto& o : ops )
+    result.push_back( o.id );
+  return result;
+}
+
+/// @return the sequence numbers of the account's history entries kept in memory, oldest first
+vector<uint32_t> sequences_in_memory( const database& db, account_id_type account )
+{
+  const auto& by_seq_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_seq>();
+  vector<uint32_t> result;
+  for ( auto itr = by_seq_idx.lower_bound( boost::make_tuple( account ) );
+        itr != by_seq_idx.end() && itr->account == account; ++itr )
+    result.push_back( itr->sequence );
+  return result;
+}
+
+}
+
 BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
 
 BOOST_FIXTURE_TEST_SUITE( account_unit_tests, database_fixture )
@@ -197,6 +243,231 @@ BOOST_AUTO_TEST_CASE( remove_limit_from_all_vaults_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( dasc_holder_index_unit_test )
+{ try {
+  const auto& bidx = dynamic_cast<const primary_index<account_balance_index>&>(db.get_index_type<account_balance_index>());
+  const auto& holders = bidx.get_secondary_index<dasc_holder_index>();
+  const auto dasc_id = get_dascoin_asset_id();
+
+  // Build the index before the changes, they have to be tracked from here on:
+  holders.top(10);
+
+  ACTOR(wallet);
+  VAULT_ACTORS((vault)(lonely));
+  CUSTODIAN_ACTOR(custodian);
+
+  db.adjust_balance(vault_id, asset(300, dasc_id));
+  db.adjust_balance(wallet_id, asset(100, dasc_id));
+  db.adjust_balance(lonely_id, asset(250, dasc_id));
+  db.adjust_balance(custodian_id, asset(250, dasc_id));
+
+  auto top = holders.top(4);
+  BOOST_REQUIRE_EQUAL(top.size(), 4);
+  BOOST_CHECK(top[0].first == vault_id && top[0].second == 300);
+  BOOST_CHECK(top[1].first == lonely_id && top[1].second == 250);
+  BOOST_CHECK(top[2].first == custodian_id && top[2].second == 250);
+  BOOST_CHECK(top[3].first == wallet_id && top[3].second == 100);
+
+  BOOST_TEST_MESSAGE("A tethered vault counts towards its wallet.");
+  tether_accounts(wallet_id, vault_id);
+  top = holders.top(3);
+  BOOST_CHECK(top[0].first == wallet_id && top[0].second == 400);
+  BOOST_CHECK(top[1].first == lonely_id && top[1].second == 250);
+
+  db.adjust_balance(vault_id, asset(-200, dasc_id));
+  top = holders.top(3);
+  BOOST_CHECK(top[0].first == lonely_id && top[0].second == 250);
+  BOOST_CHECK(top[1].first == custodian_id && top[1].second == 250);
+  BOOST_CHECK(top[2].first == wallet_id && top[2].second == 200);
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( account_history_by_operation_unit_test )
+{ try {
+  ACTOR(alice);
+
+  issue_webasset("1", alice_id, 100, 100);
+  issue_webasset("2", alice_id, 100, 100);
+  issue_webasset("3", alice_id, 100, 100);
+  generate_block();
+
+  graphene::app::history_api hist_api(app);
+  const uint32_t issue_type = operation::tag<asset_create_issue_request_operation>::value;
+  const auto ids_of = [](const vector<operation_history_object>& ops) {
+    vector<object_id_type> result;
+    for ( const auto& o : ops )
+      result.push_back(o.id);
+    return result;
+  };
+
+  // Filtering through the index yields the same operations as filtering the full history:
+  vector<object_id_type> expected;
+  for ( const auto& o : hist_api.get_account_history(alice_id) )
+    if ( o.op.which() == static_cast<int>(issue_type) )
+      expected.push_back(o.id);
+  BOOST_REQUIRE_EQUAL( expected.size(), 3 );
+  BOOST_CHECK( ids_of(hist_api.get_account_history_by_operation(alice_id, {issue_type})) == expected );
+
+  // Start is inclusive, stop is exclusive:
+  BOOST_CHECK( ids_of(hist_api.get_account_history_by_operation(alice_id, {issue_type}, operation_history_id_type(), 2, expected[1]))
+               == vector<object_id_type>({expected[1], expected[2]}) );
+  BOOST_CHECK( ids_of(hist_api.get_account_history_by_operation(alice_id, {issue_type}, expected[2], 100))
+               == vector<object_id_type>({expected[0], expected[1]}) );
+
+  // Same by sequence number:
+  const auto newest = hist_api.get_relative_account_history_by_operation(alice_id, {issue_type}, 0, 1, 0);
+  BOOST_REQUIRE_EQUAL( newest.size(), 1 );
+  BOOST_CHECK( newest[0].id == expected[0] );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( cold_history_store_unit_test )
+{ try {
+  using graphene::account_history::cold_history_store;
+  fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+  cold_history_store store;
+  store.open( dir.path() );
+
+  const auto append = [&store](account_id_type account, uint32_t sequence, uint64_t op_id) {
+    operation_history_object op;
+    op.id = operation_history_id_type(op_id);
+    op.block_num = sequence;
+    account_transaction_history_object entry;
+    entry.account = account;
+    entry.sequence = sequence;
+    entry.operation_id = op.id;
+    store.append( entry, op );
+  };
+  const auto sequences = [&store](account_id_type account, uint32_t start) {
+    vector<uint32_t> result;
+    store.for_each( account, start, [&](const cold_history_store::record& r) {
+      result.push_back( r.sequence );
+      return true;
+    } );
+    return result;
+  };
+
+  const account_id_type alice_id(10), bob_id(11);
+  append(alice_id, 1, 3);
+  append(bob_id, 1, 4);
+  append(alice_id, 2, 7);
+  append(alice_id, 3, 9);
+  // Entries already stored are not stored again:
+  append(alice_id, 2, 7);
+
+  BOOST_CHECK( sequences(alice_id, 100) == vector<uint32_t>({3, 2, 1}) );
+  BOOST_CHECK( sequences(alice_id, 2) == vector<uint32_t>({2, 1}) );
+  BOOST_CHECK( sequences(bob_id, 100) == vector<uint32_t>({1}) );
+  BOOST_CHECK_EQUAL( store.newest_sequence(alice_id), 3u );
+  BOOST_CHECK_EQUAL( store.find_sequence(alice_id, operation_history_id_type(2)), 0u );
+  BOOST_CHECK_EQUAL( store.find_sequence(alice_id, operation_history_id_type(8)), 2u );
+  BOOST_CHECK_EQUAL( store.find_sequence(alice_id, operation_history_id_type(20)), 3u );
+
+  // The records are found again after reopening the store:
+  store.close();
+  store.open( dir.path() );
+  BOOST_CHECK( sequences(alice_id, 100) == vector<uint32_t>({3, 2, 1}) );
+  store.for_each( alice_id, 2, [&](const cold_history_store::record& r) {
+    const operation_history_object op = store.load( r );
+    BOOST_CHECK( op.id == operation_history_id_type(7) );
+    BOOST_CHECK_EQUAL( op.block_num, 2u );
+    return false;
+  } );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE( account_history_max_ops_cold_store_test, max_ops_history_fixture )
+{ try {
+  ACTOR(alice);
+
+  for ( int i = 0; i < 5; ++i )
+    issue_webasset(fc::to_string(i), alice_id, 100, 100);
+  generate_block();
+  // Entries leave memory once their block is irreversible, when the account gets a new entry:
+  generate_blocks(20);
+  issue_webasset("5", alice_id, 100, 100);
+  generate_block();
+
+  const auto plugin = app.get_plugin<graphene::account_history::account_history_plugin>("account_history");
+  BOOST_REQUIRE( plugin->cold_store() != nullptr );
+  const uint32_t total_ops = alice_id(db).statistics(db).total_ops;
+  const uint32_t cold_seq = plugin->cold_store()->newest_sequence(alice_id);
+  const auto in_memory = sequences_in_memory(db, alice_id);
+  BOOST_REQUIRE_GT( cold_seq, 2u );
+  BOOST_REQUIRE( !in_memory.empty() );
+  BOOST_CHECK_EQUAL( in_memory.front(), cold_seq + 1 );
+  BOOST_CHECK_EQUAL( in_memory.back(), total_ops );
+  BOOST_CHECK_EQUAL( in_memory.size(), total_ops - cold_seq );
+
+  // The history reads on from the memory into the cold store, all[i] is the entry with sequence total_ops - i:
+  graphene::app::history_api hist_api(app);
+  const auto all = ids_of(hist_api.get_account_history(alice_id));
+  BOOST_REQUIRE_EQUAL( all.size(), total_ops );
+  BOOST_CHECK( std::is_sorted(all.rbegin(), all.rend()) );
+  const auto at_seq = [&](uint32_t seq) { return all[total_ops - seq]; };
+
+  // Pages across the boundary, by operation id and by sequence number:
+  BOOST_CHECK( ids_of(hist_api.get_account_history(alice_id, at_seq(cold_seq - 1), 100, at_seq(cold_seq + 1)))
+               == vector<object_id_type>({at_seq(cold_seq + 1), at_seq(cold_seq)}) );
+  BOOST_CHECK( ids_of(hist_api.get_relative_account_history(alice_id, cold_seq - 1, 100, cold_seq + 1))
+               == vector<object_id_type>({at_seq(cold_seq + 1), at_seq(cold_seq)}) );
+  BOOST_CHECK( ids_of(hist_api.get_relative_account_history(alice_id, 0, 2, cold_seq))
+               == vector<object_id_type>({at_seq(cold_seq), at_seq(cold_seq - 1)}) );
+
+  // A stop of 0 leaves out the first entry of the account, like a stop of 1:
+  const auto relative = ids_of(hist_api.get_relative_account_history(alice_id, 0, 100, 0));
+  BOOST_CHECK( relative == vector<object_id_type>(all.begin(), all.end() - 1) );
+  BOOST_CHECK( ids_of(hist_api.get_relative_account_history(alice_id, 1, 100, 0)) == relative );
+  BOOST_CHECK( ids_of(hist_api.get_relative_account_history(alice_id, 0, 100, total_ops + 10)) == relative );
+
+  // Filtering by type merges the types in memory and reads on in the cold store:
+  const uint32_t issue_type = operation::tag<asset_create_issue_request_operation>::value;
+  vector<object_id_type> expected;
+  for ( const auto& o : hist_api.get_account_history(alice_id) )
+    if ( o.op.which() == static_cast<int>(issue_type) )
+      expected.push_back(o.id);
+  BOOST_REQUIRE_EQUAL( expected.size(), 6 );
+  BOOST_CHECK( ids_of(hist_api.get_account_history_by_operation(alice_id, {issue_type})) == expected );
+  BOOST_CHECK( ids_of(hist_api.get_relative_account_history_by_operation(alice_id, {issue_type}, 0, 100, 0)) == expected );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE( account_history_retention_cold_store_test, retention_history_fixture )
+{ try {
+  ACTOR(alice);
+
+  issue_webasset("1", alice_id, 100, 100);
+  issue_webasset("2", alice_id, 100, 100);
+  generate_block();
+
+  graphene::app::history_api hist_api(app);
+  const auto before = ids_of(hist_api.get_account_history(alice_id));
+  const uint32_t ops_before = alice_id(db).statistics(db).total_ops;
+  BOOST_REQUIRE_EQUAL( before.size(), ops_before );
+
+  // A day later, once the blocks of the new day are irreversible, the older entries and their operations leave memory:
+  generate_blocks(db.head_block_time() + fc::days(1));
+  generate_blocks(20);
+
+  const auto plugin = app.get_plugin<graphene::account_history::account_history_plugin>("account_history");
+  BOOST_REQUIRE( plugin->cold_store() != nullptr );
+  BOOST_CHECK_GE( plugin->cold_store()->newest_sequence(alice_id), ops_before );
+  for ( auto seq : sequences_in_memory(db, alice_id) )
+    BOOST_CHECK_GT( seq, ops_before );
+  for ( const auto& id : before )
+    BOOST_CHECK( db.find_object(id) == nullptr );
+
+  // The history reads the same from the cold store:
+  const auto after = ids_of(hist_api.get_account_history(alice_id));
+  BOOST_REQUIRE_GE( after.size(), before.size() );
+  BOOST_CHECK( vector<object_id_type>(after.end() - before.size(), after.end()) == before );
+  BOOST_CHECK( ids_of(hist_api.get_relative_account_history(alice_id, 0, 100, ops_before))
+               == vector<object_id_type>(before.begin(), before.end() - 1) );
+  BOOST_CHECK( ids_of(hist_api.get_account_history(alice_id, before[1], 100, before[0]))
+               == vector<object_id_type>({before[0]}) );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE(starting_amount_of_cycle_asset_test)
 {
   try
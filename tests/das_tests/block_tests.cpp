@@ -0,0 +1,169 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/committee_member_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <limits>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( block_unit_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( precompute_signature_keys_test )
+{ try {
+   ACTORS((a0)(a1)(a2)(a3)(a4)(a5)(a6)(a7));
+   generate_block();
+
+   // One transaction signed by every actor, enough of them to recover the keys on worker threads:
+   const vector<std::pair<account_id_type, fc::ecc::private_key>> signers{
+      {a0_id, a0_private_key}, {a1_id, a1_private_key}, {a2_id, a2_private_key}, {a3_id, a3_private_key},
+      {a4_id, a4_private_key}, {a5_id, a5_private_key}, {a6_id, a6_private_key}, {a7_id, a7_private_key}
+   };
+   vector<signed_transaction> trxs;
+   for( const auto& s : signers )
+   {
+      account_update_operation op;
+      op.account = s.first;
+      op.new_options = s.first(db).options;
+      op.new_options->memo_key = generate_private_key( s.first(db).name + "_memo" ).get_public_key();
+      signed_transaction t;
+      t.operations.push_back( op );
+      set_expiration( db, t );
+      sign( t, s.second );
+      trxs.push_back( t );
+   }
+
+   // A copy made by unpacking caches no keys, its keys are recovered in place:
+   const auto serially_recovered = [this]( const signed_transaction& t ) {
+      return fc::raw::unpack<signed_transaction>( fc::raw::pack( t ) ).get_signature_keys( db.get_chain_id() );
+   };
+
+   vector<signed_transaction> copies;
+   vector<const signed_transaction*> to_precompute;
+   for( const auto& t : trxs )
+      copies.push_back( fc::raw::unpack<signed_transaction>( fc::raw::pack( t ) ) );
+   for( const auto& t : copies )
+      to_precompute.push_back( &t );
+   db.precompute_signature_keys( to_precompute );
+   for( size_t i = 0; i < trxs.size(); ++i )
+   {
+      BOOST_CHECK( copies[i].get_signature_keys( db.get_chain_id() ) == serially_recovered( trxs[i] ) );
+      BOOST_CHECK( copies[i].get_signature_keys( db.get_chain_id() )
+                   == flat_set<public_key_type>({ signers[i].second.get_public_key() }) );
+   }
+
+   // A second node, in sync with the first one:
+   fc::temp_directory dir2( graphene::utilities::temp_directory_path() );
+   database db2;
+   db2.open( dir2.path(), [this]{ return genesis_state; }, "test" );
+   for( uint32_t n = 1; n <= db.head_block_num(); ++n )
+      PUSH_BLOCK( db2, *db.fetch_block_by_number( n ), ~0 );
+
+   // The transactions are pending on the first node when it receives a block without them. The pending
+   // transactions are restored after the block, with their keys recovered on worker threads:
+   for( const auto& t : trxs )
+      PUSH_TX( db, t, database::skip_nothing );
+   const signed_block other = db2.generate_block( db2.get_slot_time( 1 ), db2.get_scheduled_witness( 1 ),
+                                                  init_account_priv_key, database::skip_nothing );
+   BOOST_CHECK( other.transactions.empty() );
+   PUSH_BLOCK( db, other, database::skip_nothing );
+
+   // All of them are still pending, and go into the next block with the keys of their signers:
+   const signed_block next = generate_block();
+   BOOST_REQUIRE_EQUAL( next.transactions.size(), trxs.size() );
+   for( size_t i = 0; i < trxs.size(); ++i )
+   {
+      BOOST_CHECK( next.transactions[i].id() == trxs[i].id() );
+      BOOST_CHECK( serially_recovered( next.transactions[i] ) == serially_recovered( trxs[i] ) );
+   }
+   for( const auto& s : signers )
+      BOOST_CHECK( s.first(db).options.memo_key == generate_private_key( s.first(db).name + "_memo" ).get_public_key() );
+
+   db2.close();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( parallel_vote_tally_test )
+{ try {
+   ACTORS((a0)(a1)(a2)(a3)(a4)(a5)(a6)(a7));
+   generate_block();
+
+   // The first node splits the tally over all cores, a second node in sync with it tallies on the chain thread:
+   fc::temp_directory dir2( graphene::utilities::temp_directory_path() );
+   database db2;
+   db2.open( dir2.path(), [this]{ return genesis_state; }, "test" );
+   for( uint32_t n = 1; n <= db.head_block_num(); ++n )
+      PUSH_BLOCK( db2, *db.fetch_block_by_number( n ), ~0 );
+   db.set_min_parallel_vote_tally( 1 );
+   db2.set_min_parallel_vote_tally( std::numeric_limits<size_t>::max() );
+
+   // The actors vote for committee members with their core balance, given to both nodes alike:
+   share_type stake = 1000;
+   for( const auto& id : { a0_id, a1_id, a2_id, a3_id, a4_id, a5_id, a6_id, a7_id } )
+   {
+      db.adjust_balance( id, asset( stake ) );
+      db2.adjust_balance( id, asset( stake ) );
+      stake += 1000;
+   }
+
+   generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+   generate_block();
+   for( uint32_t n = db2.head_block_num() + 1; n <= db.head_block_num(); ++n )
+      PUSH_BLOCK( db2, *db.fetch_block_by_number( n ), ~0 );
+   BOOST_REQUIRE( db2.head_block_id() == db.head_block_id() );
+
+   const auto& gpo = db.get_global_properties();
+   const auto& gpo2 = db2.get_global_properties();
+   BOOST_CHECK( gpo.active_committee_members == gpo2.active_committee_members );
+   BOOST_CHECK( gpo.active_witnesses == gpo2.active_witnesses );
+
+   bool any_votes = false;
+   for( const committee_member_object& c : db.get_index_type<committee_member_index>().indices() )
+   {
+      BOOST_CHECK_EQUAL( c.total_votes, db2.get<committee_member_object>( c.id ).total_votes );
+      any_votes = any_votes || c.total_votes > 0;
+   }
+   BOOST_CHECK( any_votes );
+   for( const witness_object& w : db.get_index_type<witness_index>().indices() )
+      BOOST_CHECK_EQUAL( w.total_votes, db2.get<witness_object>( w.id ).total_votes );
+
+   db2.close();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,7 @@
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/das33_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/app/database_api.hpp>
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -163,6 +164,37 @@ BOOST_AUTO_TEST_CASE( das33_project_test_fails )
     BOOST_CHECK_EQUAL(get_das33_projects().size(), 1);
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( das33_project_token_index_test )
+{ try {
+    VAULT_ACTOR(owner);
+    auto das33_admin_id = get_das33_administrator_id();
+
+    asset_id_type token1 = create_new_asset("TESTA", 100000000, 2, price({asset(1),asset(1,asset_id_type(1))}));
+    asset_id_type token2 = create_new_asset("TESTB", 100000000, 2, price({asset(1),asset(1,asset_id_type(1))}));
+    vector<price> prices1{ price{ asset{10, get_cycle_asset_id()}, asset{100, token1} } };
+    vector<price> prices2{ price{ asset{10, get_cycle_asset_id()}, asset{100, token2} } };
+
+    do_op(das33_project_create_operation(das33_admin_id, "test_project1", owner_id, token1, prices1, 10000));
+    const auto& by_token_idx = db.get_index_type<das33_project_index>().indices().get<by_token>();
+    BOOST_REQUIRE(by_token_idx.find(token1) != by_token_idx.end());
+    BOOST_CHECK_EQUAL(by_token_idx.find(token1)->name, "test_project1");
+    BOOST_CHECK(by_token_idx.find(token2) == by_token_idx.end());
+
+    // A token can only be used by one project
+    GRAPHENE_REQUIRE_THROW(
+        do_op(das33_project_create_operation(das33_admin_id, "test_project2", owner_id, token1, prices1, 10000)),
+        fc::exception );
+    do_op(das33_project_create_operation(das33_admin_id, "test_project2", owner_id, token2, prices2, 10000));
+    BOOST_CHECK_EQUAL(get_das33_projects().size(), 2);
+    BOOST_CHECK_EQUAL(by_token_idx.find(token2)->name, "test_project2");
+
+    // Deleting a project frees its token
+    do_op(das33_project_delete_operation(das33_admin_id, by_token_idx.find(token1)->id));
+    BOOST_CHECK(by_token_idx.find(token1) == by_token_idx.end());
+    do_op(das33_project_create_operation(das33_admin_id, "test_project3", owner_id, token1, prices1, 10000));
+    BOOST_CHECK_EQUAL(by_token_idx.find(token1)->name, "test_project3");
+} FC_LOG_AND_RETHROW() }
+
 /** DISABLED (Cannot pledge cycles) **
 BOOST_AUTO_TEST_CASE( das33_pledge_cycles_test )
 { try {
@@ -298,6 +330,11 @@ BOOST_AUTO_TEST_CASE( das33_pledge_dasc_test )
     do_op(das33_pledge_asset_operation(user_id, asset{10 * DASCOIN_DEFAULT_ASSET_PRECISION, get_dascoin_asset_id()}, optional<license_type_id_type>{}, project.id));
     BOOST_CHECK_EQUAL(get_das33_pledges().size(), 2);
 
+    // Project keeps a running total of pledged assets
+    const auto& total_pledged = project.id(db).total_pledged;
+    BOOST_CHECK_EQUAL(total_pledged.size(), 1);
+    BOOST_CHECK_EQUAL(total_pledged.at(get_dascoin_asset_id()).value, 20 * DASCOIN_DEFAULT_ASSET_PRECISION);
+
     // Should Fail: when pledging other than cycles, license must not be provided
     GRAPHENE_REQUIRE_THROW( do_op(das33_pledge_asset_operation(user_id, asset{50, get_dascoin_asset_id()}, license_type_id_type{}, project.id));, fc::exception );
 
@@ -306,6 +343,75 @@ BOOST_AUTO_TEST_CASE( das33_pledge_dasc_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( das33_pledges_by_account_paged_test )
+{ try {
+
+    ACTOR(user);
+    VAULT_ACTOR(owner);
+
+    tether_accounts(user_id, owner_id);
+
+    issue_dascoin(owner_id, 100);
+    disable_vault_to_wallet_limit(owner_id);
+    transfer_dascoin_vault_to_wallet(owner_id, user_id, 100 * DASCOIN_DEFAULT_ASSET_PRECISION);
+
+    // Create and activate a das33 project
+    asset_id_type test_asset_id = create_new_asset("TEST", 100000000, 2, price({asset(1),asset(1,asset_id_type(1))}));
+    vector<price> prices{
+        {
+            asset{1 * DASCOIN_DEFAULT_ASSET_PRECISION, get_dascoin_asset_id()},
+            asset{1, test_asset_id}
+        }
+    };
+    das33_project_create_operation project_create;
+        project_create.authority      = get_das33_administrator_id();
+        project_create.name           = "test_project0";
+        project_create.owner          = owner_id;
+        project_create.token          = test_asset_id;
+        project_create.ratios         = prices;
+        project_create.min_to_collect = 10000;
+    do_op(project_create);
+
+    das33_project_object project = get_das33_projects()[0];
+
+    das33_project_update_operation project_update;
+        project_update.project_id = project.id;
+        project_update.authority  = get_das33_administrator_id();
+        project_update.status     = das33_project_status::active;
+    do_op(project_update);
+
+    for( int i = 0; i < 5; ++i )
+       do_op(das33_pledge_asset_operation(user_id, asset{10 * DASCOIN_DEFAULT_ASSET_PRECISION, get_dascoin_asset_id()}, optional<license_type_id_type>{}, project.id));
+
+    graphene::app::database_api db_api(db, app.chain_notifications());
+    const auto all = db_api.get_das33_pledges_by_account(user_id);
+    BOOST_REQUIRE_EQUAL(all.size(), 5);
+    BOOST_CHECK_EQUAL(db_api.get_das33_pledges_by_account(owner_id).size(), 0);
+
+    // The first page starts at the first pledge of the account
+    auto page = db_api.get_das33_pledges_by_account_paged(user_id, das33_pledge_holder_id_type(), 2);
+    BOOST_REQUIRE_EQUAL(page.size(), 2);
+    BOOST_CHECK(page[0].id == all[0].id);
+    BOOST_CHECK(page[1].id == all[1].id);
+
+    // The cursor is the first pledge of the page
+    page = db_api.get_das33_pledges_by_account_paged(user_id, page.back().id, 3);
+    BOOST_REQUIRE_EQUAL(page.size(), 3);
+    BOOST_CHECK(page[0].id == all[1].id);
+    BOOST_CHECK(page[2].id == all[3].id);
+
+    // The last page ends with the last pledge of the account
+    page = db_api.get_das33_pledges_by_account_paged(user_id, page.back().id, 100);
+    BOOST_REQUIRE_EQUAL(page.size(), 2);
+    BOOST_CHECK(page[0].id == all[3].id);
+    BOOST_CHECK(page[1].id == all[4].id);
+    BOOST_CHECK_EQUAL(db_api.get_das33_pledges_by_account_paged(owner_id, all[0].id, 100).size(), 0);
+
+    // Should Fail: more than 100 pledges per page
+    GRAPHENE_REQUIRE_THROW( db_api.get_das33_pledges_by_account_paged(user_id, all[0].id, 101), fc::exception );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( das33_pledge_test )
 { try {
 
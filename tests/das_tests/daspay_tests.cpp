@@ -162,6 +162,35 @@ BOOST_AUTO_TEST_CASE( delayed_operations_index_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( delayed_operations_due_time_index_test )
+{ try {
+  ACTORS((wa1)(wa2)(wa3));
+
+  const auto& now = db.head_block_time();
+  const auto create_delayed = [&](account_id_type account, fc::time_point_sec issued_time, uint32_t skip) {
+    return db.create<delayed_operation_object>([&](delayed_operation_object& dlo){
+      dlo.account = account;
+      dlo.issued_time = issued_time;
+      dlo.skip = skip;
+      dlo.op = unreserve_asset_on_account_operation{account, asset{ 0, db.get_dascoin_asset_id() } };
+    }).id;
+  };
+
+  const auto late_id = create_delayed(wa1_id, now, 300);
+  const auto early_id = create_delayed(wa2_id, now + 60, 60);
+  const auto middle_id = create_delayed(wa3_id, now - 100, 300);
+
+  // Ordered by issued_time + skip, regardless of the account:
+  const auto& idx = db.get_index_type<delayed_operations_index>().indices().get<by_due_time>();
+  vector<object_id_type> order;
+  for ( const auto& dlo : idx )
+    order.push_back(dlo.id);
+
+  BOOST_CHECK( order == vector<object_id_type>({early_id, middle_id, late_id}) );
+  BOOST_CHECK( idx.begin()->due_time() == now + 120 );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( register_daspay_authority_test )
 { try {
   ACTORS((foo)(bar)(foobar)(payment));
@@ -77,6 +77,47 @@ BOOST_AUTO_TEST_CASE( successful_orders_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( limit_order_price_level_index_unit_test )
+{ try {
+    ACTOR(alice);
+
+    const auto& web_id = get_web_asset_id();
+    const auto& das_id = get_dascoin_asset_id();
+    const auto create_order = [&](share_type sell, share_type receive) -> const limit_order_object& {
+      return db.create<limit_order_object>([&](limit_order_object& loo){
+        loo.seller = alice_id;
+        loo.for_sale = sell;
+        loo.sell_price = asset{sell, web_id} / asset{receive, das_id};
+        loo.expiration = time_point_sec::maximum();
+      });
+    };
+    const auto& idx = dynamic_cast<const primary_index<limit_order_index>&>(db.get_index_type<limit_order_index>());
+    const auto& levels_idx = idx.get_secondary_index<limit_order_price_level_index>();
+
+    const auto& o1 = create_order(100, 200);
+    const auto& o2 = create_order(50, 100);   // same price as o1
+    const auto& o3 = create_order(300, 200);
+    create_order(100, 300);
+
+    const auto& levels = levels_idx.get_levels(web_id, das_id);
+    BOOST_CHECK_EQUAL( levels.size(), 3 );
+    BOOST_CHECK( levels.begin()->first == o3.sell_price );
+    BOOST_CHECK_EQUAL( levels.at(o1.sell_price), 2 );
+    BOOST_CHECK( levels_idx.get_levels(das_id, web_id).empty() );
+
+    // Best prices are the same as walking the by_price index:
+    flat_set<share_type> prices;
+    db.get_groups_of_limit_order_prices(web_id, das_id, prices, false, 2);
+    BOOST_CHECK_EQUAL( prices.size(), 2 );
+
+    db.remove(o3);
+    db.remove(o1);
+    BOOST_CHECK_EQUAL( levels.size(), 2 );
+    BOOST_CHECK_EQUAL( levels.begin()->second, 1 );
+    BOOST_CHECK( levels.begin()->first == o2.sell_price );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( transfer_custodian )
 { try {
     ACTOR(alice);
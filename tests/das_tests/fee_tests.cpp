@@ -117,7 +117,7 @@ BOOST_AUTO_TEST_CASE( successful_fee_change_and_fee_charge_with_fee_burn_test )
    std::tie(cash, reserved) = get_web_asset_amounts(alice_id);
 
    // test db_api->get_required_fees
-   graphene::app::database_api db_api(db);
+   graphene::app::database_api db_api(db, app.chain_notifications());
    vector<operation> ops;
    ops.push_back(limit_order_create_operation());
 
@@ -293,6 +293,114 @@ BOOST_AUTO_TEST_CASE( different_license_kinds_unit_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( license_total_cycles_index_unit_test )
+{ try {
+  VAULT_ACTORS((foo)(bar)(foobar));
+
+  const auto& lidx = dynamic_cast<const primary_index<license_information_index>&>(db.get_index_type<license_information_index>());
+  const auto& totals = lidx.get_secondary_index<license_total_cycles_index>();
+  auto check_totals = [&]() {
+    total_cycles_res expected;
+    for ( const auto& id : {foo_id, bar_id, foobar_id} )
+    {
+      auto vault_cycles = _dal.get_total_cycles(id);
+      if ( vault_cycles.valid() )
+      {
+        expected.total_cycles += vault_cycles->total_cycles;
+        expected.total_dascoin += vault_cycles->total_dascoin;
+      }
+    }
+    BOOST_CHECK_EQUAL( totals.total_cycles().value, expected.total_cycles.value );
+    BOOST_CHECK_EQUAL( totals.total_dascoin().value, expected.total_dascoin.value );
+  };
+
+  auto standard_locked = *(_dal.get_license_type("standard_locked"));
+  auto executive_locked = *(_dal.get_license_type("executive_locked"));
+  auto standard = *(_dal.get_license_type("standard"));
+  const time_point_sec issue_time = db.head_block_time();
+
+  check_totals();
+
+  // Regular licenses do not count:
+  do_op(issue_license_operation(get_license_issuer_id(), foobar_id, standard.id, 50, 200, issue_time));
+  check_totals();
+
+  do_op(issue_license_operation(get_license_issuer_id(), foo_id, standard_locked.id, 50, 20, issue_time));
+  do_op(issue_license_operation(get_license_issuer_id(), bar_id, standard_locked.id, 0, 30, issue_time));
+  check_totals();
+  BOOST_CHECK( totals.total_cycles() > 0 );
+
+  do_op(issue_license_operation(get_license_issuer_id(), foo_id, executive_locked.id, 50, 20, issue_time));
+  do_op(submit_cycles_to_queue_by_license_operation(foo_id, 1000, executive_locked.id, 20, "TEST"));
+  check_totals();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( upgradeable_license_index_unit_test )
+{ try {
+  VAULT_ACTOR(foo);
+
+  const auto& lidx = dynamic_cast<const primary_index<license_information_index>&>(db.get_index_type<license_information_index>());
+  const auto& upgradeable = lidx.get_secondary_index<upgradeable_license_index>();
+
+  auto standard = *(_dal.get_license_type("standard"));
+  const time_point_sec now = db.head_block_time();
+
+  BOOST_CHECK( upgradeable.activated_before(now + fc::days(1)).empty() );
+
+  do_op(issue_license_operation(get_license_issuer_id(), foo_id, standard.id, 0, 200, now - fc::days(1)));
+  const auto& foo_lio = *foo.license_information;
+  BOOST_CHECK( upgradeable.activated_before(now - fc::days(2)).empty() );
+  auto eligible = upgradeable.activated_before(now);
+  BOOST_REQUIRE_EQUAL( eligible.size(), 1 );
+  BOOST_CHECK( eligible[0] == foo_lio );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( upgradeable_license_index_modify_test )
+{ try {
+  VAULT_ACTORS((foo)(bar));
+
+  const auto& lidx = dynamic_cast<const primary_index<license_information_index>&>(db.get_index_type<license_information_index>());
+  const auto& upgradeable = lidx.get_secondary_index<upgradeable_license_index>();
+  const auto& dgpo = db.get_dynamic_global_properties();
+
+  auto standard = *(_dal.get_license_type("standard"));
+  const time_point_sec now = db.head_block_time();
+
+  do_op(issue_license_operation(get_license_issuer_id(), foo_id, standard.id, 0, 200, now - fc::days(1)));
+  do_op(issue_license_operation(get_license_issuer_id(), bar_id, standard.id, 0, 200, now - fc::days(2)));
+  const auto foo_lio = *foo.license_information;
+  const auto bar_lio = *bar.license_information;
+
+  auto eligible = upgradeable.activated_before(now);
+  BOOST_REQUIRE_EQUAL( eligible.size(), 2 );
+  BOOST_CHECK( eligible[0] == bar_lio );
+  BOOST_CHECK( eligible[1] == foo_lio );
+
+  // Activating the license of foo earlier moves it ahead of bar, without leaving it in its old place:
+  db.modify(foo_lio(db), [&](license_information_object& lio){
+    lio.history[0].activated_at = now - fc::days(3);
+  });
+  eligible = upgradeable.activated_before(now);
+  BOOST_REQUIRE_EQUAL( eligible.size(), 2 );
+  BOOST_CHECK( eligible[0] == foo_lio );
+  BOOST_CHECK( eligible[1] == bar_lio );
+  eligible = upgradeable.activated_before(now - fc::days(2) - fc::seconds(1));
+  BOOST_REQUIRE_EQUAL( eligible.size(), 1 );
+  BOOST_CHECK( eligible[0] == foo_lio );
+
+  // The standard license upgrades once, after the upgrade event both licenses drop out of the set:
+  do_op(create_upgrade_event_operation(get_license_administrator_id(), dgpo.next_maintenance_time, {}, {}, "foo"));
+  generate_blocks(dgpo.next_maintenance_time);
+  generate_block();
+
+  BOOST_CHECK( !foo_lio(db).history[0].balance_upgrade.has_remaining_upgrades() );
+  BOOST_CHECK( !bar_lio(db).history[0].balance_upgrade.has_remaining_upgrades() );
+  BOOST_CHECK( upgradeable.activated_before(db.head_block_time() + fc::days(1)).empty() );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( upgrade_event_index_test )
 { try {
 
@@ -234,9 +234,18 @@ BOOST_AUTO_TEST_CASE( limit_reset_test )
   // Wait for the limit interval to pass:
   generate_blocks(dgp.next_spend_limit_reset + fc::seconds(10));
 
-  // Check the limit again:
+  // Check the limit again, the balance is reset when it is used:
   const auto& balance_reset = db.get_balance_object(vault_id, DASCOIN_ASSET_ID);
+  BOOST_CHECK_EQUAL( db.get_spending_limit(balance_reset).value, expected_limit.value );
+  BOOST_CHECK_EQUAL( db.get_spent_amount(balance_reset).value, 0 );
+  // The APIs report the values of the reset before it is applied:
+  const auto reported = db.object_to_variant(balance_reset).as<account_balance_object>();
+  BOOST_CHECK_EQUAL( reported.limit.value, expected_limit.value );
+  BOOST_CHECK_EQUAL( reported.spent.value, 0 );
+  BOOST_CHECK_EQUAL( reported.limit_epoch, dgp.spend_limit_epoch );
+  db.update_spending_limit(balance_reset);
   BOOST_CHECK_EQUAL( balance_reset.limit.value, expected_limit.value );
+  BOOST_CHECK_EQUAL( balance_reset.limit_epoch, dgp.spend_limit_epoch );
 
 } FC_LOG_AND_RETHROW() }
 
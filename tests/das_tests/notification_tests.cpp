@@ -0,0 +1,163 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/database.hpp>
+#include <graphene/app/database_api.hpp>
+#include <graphene/app/notification_hub.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+using namespace graphene::app;
+
+namespace {
+
+struct recording_session : public notification_session
+{
+   object_id_type watched;
+   vector<fc::variant> payloads;
+   vector<object_id_type> subscribed;
+   bool account_impacted = false;
+
+   void on_objects_notification( const object_notification_batch& batch, bool impacted, const vector<size_t>& items ) override
+   {
+      account_impacted |= impacted;
+      for( size_t i = 0; i < batch.ids().size(); ++i )
+         if( batch.ids()[i] == watched )
+            payloads.push_back( batch.get_payload( i ) );
+      for( auto i : items )
+         subscribed.push_back( batch.ids()[i] );
+   }
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( notification_unit_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( notification_hub_unit_test )
+{ try {
+   ACTORS((alice)(bob));
+
+   // All sessions of the application share the hub of its chain database:
+   auto hub = app.chain_notifications();
+
+   recording_session alice_session, bob_session;
+   hub->add_session( &alice_session );
+   hub->add_session( &bob_session );
+   hub->subscribe_to_account( &alice_session, alice_id );
+
+   // The issue record is a new object impacting alice:
+   const auto record_id = issue_webasset("1", alice_id, 100, 100)->id;
+   alice_session.watched = bob_session.watched = record_id;
+   generate_block();
+
+   // Only the session subscribed to alice is told that alice was impacted:
+   BOOST_CHECK( alice_session.account_impacted );
+   BOOST_CHECK( !bob_session.account_impacted );
+
+   // Both sessions got the same variant of the record:
+   BOOST_REQUIRE_EQUAL( alice_session.payloads.size(), 1 );
+   BOOST_REQUIRE_EQUAL( bob_session.payloads.size(), 1 );
+   BOOST_CHECK_EQUAL( fc::json::to_string( alice_session.payloads[0] ), fc::json::to_string( bob_session.payloads[0] ) );
+   BOOST_CHECK_EQUAL( fc::json::to_string( alice_session.payloads[0] ), fc::json::to_string( db.get_object( record_id ).to_variant() ) );
+
+   // Object subscriptions are exact, only the subscribed session is told about the object:
+   const auto& bob_balance_id = db.get_balance_object( bob_id, get_web_asset_id() ).id;
+   hub->subscribe_to_item( &bob_session, bob_balance_id );
+   BOOST_CHECK( hub->is_subscribed_to_item( &bob_session, bob_balance_id ) );
+   BOOST_CHECK( !hub->is_subscribed_to_item( &alice_session, bob_balance_id ) );
+   BOOST_CHECK_EQUAL( hub->get_statistics().subscribed_items, 1 );
+
+   issue_webasset("2", bob_id, 100, 100);
+   generate_block();
+
+   BOOST_CHECK( alice_session.subscribed.empty() );
+   BOOST_REQUIRE_EQUAL( bob_session.subscribed.size(), 1 );
+   BOOST_CHECK( bob_session.subscribed[0] == bob_balance_id );
+   BOOST_CHECK_EQUAL( hub->get_statistics().item_matches, 1 );
+
+   // The number of accounts a session can subscribe to is limited:
+   for( uint64_t i = 0; i < notification_hub::max_accounts_per_session; ++i )
+      hub->subscribe_to_account( &bob_session, account_id_type( i ) );
+   hub->subscribe_to_account( &bob_session, account_id_type( 0 ) );
+   GRAPHENE_REQUIRE_THROW( hub->subscribe_to_account( &bob_session, account_id_type( notification_hub::max_accounts_per_session ) ),
+                           fc::exception );
+   hub->unsubscribe_from_accounts( &bob_session );
+   hub->subscribe_to_account( &bob_session, account_id_type( notification_hub::max_accounts_per_session ) );
+
+   // So is the number of objects, further objects are not subscribed to:
+   for( uint64_t i = 0; i < notification_hub::max_items_per_session; ++i )
+      hub->subscribe_to_item( &alice_session, account_id_type( i ) );
+   hub->subscribe_to_item( &alice_session, account_id_type( 0 ) );
+   hub->subscribe_to_item( &alice_session, bob_balance_id );
+   BOOST_CHECK( !hub->is_subscribed_to_item( &alice_session, bob_balance_id ) );
+   BOOST_CHECK( hub->is_subscribed_to_item( &alice_session, account_id_type( 0 ) ) );
+
+   hub->remove_session( &alice_session );
+   hub->remove_session( &bob_session );
+   BOOST_CHECK_EQUAL( hub->get_statistics().sessions, 0 );
+   BOOST_CHECK_EQUAL( hub->get_statistics().subscribed_items, 0 );
+   BOOST_CHECK_EQUAL( hub->get_statistics().subscribed_accounts, 0 );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( get_objects_past_subscription_limit_test )
+{ try {
+   ACTORS((alice));
+
+   database_api db_api( db, app.chain_notifications() );
+   db_api.set_subscribe_callback( []( const fc::variant& ) {}, false );
+
+   // Reading objects subscribes the session to them, up to the limit:
+   vector<object_id_type> ids;
+   for( uint64_t i = 0; i < notification_hub::max_items_per_session; ++i )
+      ids.push_back( account_id_type( 1000000 + i ) );
+   BOOST_CHECK_EQUAL( db_api.get_objects( ids ).size(), ids.size() );
+   BOOST_CHECK_EQUAL( db_api.get_subscription_statistics().subscribed_items, notification_hub::max_items_per_session );
+
+   // Past it the reads still return the objects, they are just not subscribed to:
+   const auto objects = db_api.get_objects( { alice_id } );
+   BOOST_REQUIRE_EQUAL( objects.size(), 1 );
+   BOOST_CHECK_EQUAL( objects[0]["name"].as_string(), "alice" );
+   const auto accounts = db_api.get_accounts( { alice_id } );
+   BOOST_REQUIRE_EQUAL( accounts.size(), 1 );
+   BOOST_REQUIRE( accounts[0].valid() );
+   BOOST_CHECK_EQUAL( accounts[0]->name, "alice" );
+   BOOST_CHECK_EQUAL( db_api.get_subscription_statistics().subscribed_items, notification_hub::max_items_per_session );
+
+   // Resetting the callback drops the subscriptions, and objects are subscribed to again:
+   db_api.set_subscribe_callback( []( const fc::variant& ) {}, false );
+   db_api.get_objects( { alice_id } );
+   BOOST_CHECK_EQUAL( db_api.get_subscription_statistics().subscribed_items, 1 );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
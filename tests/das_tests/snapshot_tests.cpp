@@ -0,0 +1,199 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/database.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+/// Pushes the blocks of source up to last that db does not have yet
+void push_blocks( database& db, const database& source, uint32_t last )
+{
+   for( uint32_t n = db.head_block_num() + 1; n <= last; ++n )
+      PUSH_BLOCK( db, *source.fetch_block_by_number( n ), ~0 );
+}
+
+/// @return a hash of every index of db as it was before the newest undo_states undo states
+std::map<std::string, fc::sha256> state_hashes( const database& db, size_t undo_states = 0 )
+{
+   std::map<std::string, fc::sha256> result;
+   for( const auto& packed : db.pack_indexes( undo_states ) )
+      result[packed.first.generic_string()] = fc::sha256::hash( packed.second.data(), packed.second.size() );
+   return result;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( snapshot_unit_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( save_and_load_snapshot_test )
+{ try {
+   ACTORS((alice)(bob));
+   issue_webasset("1", alice_id, 100, 100);
+   generate_blocks(30);
+   issue_webasset("2", bob_id, 100, 100);
+   generate_block();
+
+   // A node without plugins, so that its state only depends on the blocks:
+   fc::temp_directory dir1( graphene::utilities::temp_directory_path() );
+   database db1;
+   db1.open( dir1.path(), [this]{ return genesis_state; }, "test" );
+   push_blocks( db1, db, db.head_block_num() );
+
+   const uint32_t head = db1.head_block_num();
+   const uint32_t last_irreversible = db1.get_dynamic_global_properties().last_irreversible_block_num;
+   BOOST_REQUIRE_GT( last_irreversible, 0u );
+   BOOST_REQUIRE_LE( last_irreversible, head );
+
+   // The snapshot holds the state of the last irreversible block:
+   fc::temp_directory snapshots( graphene::utilities::temp_directory_path() );
+   const fc::path snapshot_dir = snapshots.path() / "snapshot";
+   db1.save_snapshot( snapshot_dir );
+   BOOST_CHECK( fc::exists( snapshot_dir / "manifest.json" ) );
+   BOOST_CHECK( !fc::exists( fc::path( snapshot_dir.generic_string() + ".tmp" ) ) );
+
+   // A second node starts from the snapshot and replays the later blocks of its block log:
+   fc::temp_directory dir2( graphene::utilities::temp_directory_path() );
+   database db2;
+   db2.open( dir2.path(), [this]{ return genesis_state; }, "test" );
+   push_blocks( db2, db, head );
+   db2.close();
+   db2.load_snapshot( snapshot_dir, dir2.path(), "test" );
+   db2.open( dir2.path(), [this]{ return genesis_state; }, "test" );
+
+   BOOST_CHECK_EQUAL( db2.head_block_num(), head );
+   BOOST_CHECK( db2.head_block_id() == db1.head_block_id() );
+   BOOST_CHECK( state_hashes( db2 ) == state_hashes( db1 ) );
+
+   // Back at the last irreversible block, both nodes agree as well:
+   BOOST_CHECK( state_hashes( db2, head - last_irreversible ) == state_hashes( db1, head - last_irreversible ) );
+
+   db2.close();
+   db1.close();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( corrupt_snapshot_test )
+{ try {
+   generate_blocks(30);
+
+   fc::temp_directory dir1( graphene::utilities::temp_directory_path() );
+   database db1;
+   db1.open( dir1.path(), [this]{ return genesis_state; }, "test" );
+   push_blocks( db1, db, db.head_block_num() );
+
+   fc::temp_directory snapshots( graphene::utilities::temp_directory_path() );
+   const fc::path snapshot_dir = snapshots.path() / "snapshot";
+   db1.save_snapshot( snapshot_dir );
+   const uint32_t head = db1.head_block_num();
+   db1.close();
+
+   // Change one byte of one of the index files:
+   fc::path index_file;
+   for( fc::recursive_directory_iterator itr( snapshot_dir / "object_database" ); itr != fc::recursive_directory_iterator(); ++itr )
+      if( fc::is_regular_file( *itr ) && fc::file_size( *itr ) > 0 )
+      {
+         index_file = *itr;
+         break;
+      }
+   BOOST_REQUIRE( !index_file.generic_string().empty() );
+   {
+      std::fstream file( index_file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary );
+      char c = 0;
+      file.read( &c, 1 );
+      c = ~c;
+      file.seekp( 0 );
+      file.write( &c, 1 );
+   }
+
+   fc::temp_directory dir2( graphene::utilities::temp_directory_path() );
+   database db2;
+   db2.open( dir2.path(), [this]{ return genesis_state; }, "test" );
+   push_blocks( db2, db, head );
+   db2.close();
+   GRAPHENE_REQUIRE_THROW( db2.load_snapshot( snapshot_dir, dir2.path(), "test" ), fc::exception );
+
+   // The rejected snapshot left the object database of the node as it was:
+   db2.open( dir2.path(), [this]{ return genesis_state; }, "test" );
+   BOOST_CHECK_GT( db2.head_block_num(), 0u );
+   db2.close();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( flush_and_reopen_test )
+{ try {
+   ACTORS((alice)(bob));
+   issue_webasset("1", alice_id, 100, 100);
+   generate_block();
+
+   fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+   const std::string account_index =
+         ( fc::path( fc::to_string( account_id_type::space_id ) ) / fc::to_string( account_id_type::type_id ) ).generic_string();
+   std::map<std::string, fc::sha256> before, after;
+   {
+      database db1;
+      db1.open( dir.path(), [this]{ return genesis_state; }, "test" );
+      push_blocks( db1, db, db.head_block_num() );
+      db1.flush();
+      before = state_hashes( db1 );
+
+      // Only the account index changes, the next flush carries the files of the other indexes over:
+      db1.modify( alice_id(db1), []( account_object& a ) { a.name = "alice-modified"; } );
+      after = state_hashes( db1 );
+      BOOST_CHECK( before[account_index] != after[account_index] );
+      before.erase( account_index );
+      BOOST_CHECK( std::all_of( before.begin(), before.end(), [&after]( const std::pair<const std::string, fc::sha256>& i ) {
+         return after[i.first] == i.second;
+      }));
+
+      BOOST_CHECK( db1.flush_async( 0 ) );
+      db1.wait_for_flush();
+      // db1 goes away without closing, which would flush again
+   }
+
+   database db2;
+   db2.open( dir.path(), [this]{ return genesis_state; }, "test" );
+   BOOST_CHECK( state_hashes( db2 ) == after );
+   BOOST_CHECK_EQUAL( alice_id(db2).name, "alice-modified" );
+   BOOST_CHECK_EQUAL( bob_id(db2).name, "bob" );
+   db2.close();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -93,7 +93,13 @@ BOOST_AUTO_TEST_CASE( block_database_test )
          fetch = bdb.fetch_optional( b.id() );
          FC_ASSERT( fetch.valid() );
          FC_ASSERT( fetch->witness ==  b.witness );
+
+         auto raw = bdb.fetch_raw( b.block_num() );
+         FC_ASSERT( raw.valid() );
+         FC_ASSERT( raw->id == b.id() );
+         FC_ASSERT( std::vector<char>( raw->data, raw->data + raw->size ) == fc::raw::pack( b ) );
       }
+      FC_ASSERT( !bdb.fetch_raw( 6 ).valid() );
 
       for( uint32_t i = 1; i < 5; ++i )
       {
@@ -119,6 +125,76 @@ BOOST_AUTO_TEST_CASE( block_database_test )
          FC_ASSERT( blk->witness == witness_id_type(blk->block_num()) );
       }
 
+      // simulate an unclean shutdown, the files keep the space they were grown by
+      b.previous = b.id();
+      b.witness = witness_id_type(6);
+      bdb.store( b.id(), b );
+      fc::path index_file = data_dir.path() / "index";
+      fc::path blocks_file = data_dir.path() / "blocks";
+      fc::copy( index_file, data_dir.path() / "index.bak" );
+      fc::copy( blocks_file, data_dir.path() / "blocks.bak" );
+      bdb.close();
+      fc::remove( index_file );
+      fc::remove( blocks_file );
+      fc::rename( data_dir.path() / "index.bak", index_file );
+      fc::rename( data_dir.path() / "blocks.bak", blocks_file );
+
+      bdb.open( data_dir.path() );
+      last = bdb.last();
+      FC_ASSERT( last );
+      FC_ASSERT( last->id() == b.id() );
+      FC_ASSERT( !bdb.fetch_raw( 7 ).valid() );
+
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( virtual_op_database_test )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      virtual_op_database vop_db;
+      vop_db.open( dir.path() );
+
+      const operation fill = fill_order_operation();
+      const operation distribute = record_distribute_dascoin_operation();
+      const operation transfer = transfer_operation();
+      const auto applied = [](const vector<operation>& ops) {
+         vector<optional<operation_history_object>> result;
+         for ( const auto& op : ops )
+            result.emplace_back( operation_history_object( op ) );
+         return result;
+      };
+      const auto types_of = [](const vector<operation>& ops) {
+         vector<int> result;
+         for ( const auto& op : ops )
+            result.push_back( op.which() );
+         return result;
+      };
+      const vector<uint16_t> both_types{ static_cast<uint16_t>(fill.which()), static_cast<uint16_t>(distribute.which()) };
+
+      // Real operations are left out, the virtual ones keep the order they were applied in:
+      vop_db.store( 1, applied({ fill, transfer, distribute, fill }) );
+      vop_db.store( 3, applied({ distribute }) );
+      BOOST_CHECK( types_of(vop_db.fetch(1, both_types)) == vector<int>({ fill.which(), distribute.which(), fill.which() }) );
+      BOOST_CHECK_EQUAL( vop_db.fetch(1, { static_cast<uint16_t>(fill.which()) }).size(), 2u );
+      BOOST_CHECK( vop_db.fetch(2, both_types).empty() );
+      BOOST_CHECK_EQUAL( vop_db.fetch(3, both_types).size(), 1u );
+
+      // Storing a block again drops it and the blocks after it:
+      vop_db.store( 1, applied({ distribute }) );
+      BOOST_CHECK( types_of(vop_db.fetch(1, both_types)) == vector<int>({ distribute.which() }) );
+      BOOST_CHECK( vop_db.fetch(3, both_types).empty() );
+
+      // The records are found again after reopening the database:
+      vop_db.store( 2, applied({ fill }) );
+      vop_db.close();
+      vop_db.open( dir.path() );
+      BOOST_CHECK( types_of(vop_db.fetch(1, both_types)) == vector<int>({ distribute.which() }) );
+      BOOST_CHECK( types_of(vop_db.fetch(2, both_types)) == vector<int>({ fill.which() }) );
+
    } catch (fc::exception& e) {
       edump((e.to_detail_string()));
       throw;
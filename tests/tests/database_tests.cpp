@@ -59,3 +59,106 @@ BOOST_AUTO_TEST_CASE( undo_test )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( savepoint_test )
+{
+   try {
+      database db;
+      auto ses = db._undo_db.start_undo_session();
+      const auto& bal_obj1 = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.balance = 1;
+      });
+      auto id1 = bal_obj1.id;
+
+      // roll back the changes made after the savepoint only
+      auto sp = db._undo_db.start_savepoint();
+      db.modify( bal_obj1, [&]( account_balance_object& obj ){ obj.balance = 2; } );
+      const auto& bal_obj2 = db.create<account_balance_object>( [&]( account_balance_object& obj ){} );
+      auto id2 = bal_obj2.id;
+      sp.undo();
+      BOOST_CHECK( id1(db).balance == 1 );
+      BOOST_CHECK( db.find( id2 ) == nullptr );
+
+      // committed changes stay in the session
+      sp = db._undo_db.start_savepoint();
+      db.modify( id1(db), [&]( account_balance_object& obj ){ obj.balance = 3; } );
+      const auto& bal_obj3 = db.create<account_balance_object>( [&]( account_balance_object& obj ){} );
+      BOOST_CHECK( bal_obj3.id == id2 );
+      sp.commit();
+      BOOST_CHECK( id1(db).balance == 3 );
+
+      ses.undo();
+      BOOST_CHECK( db.find( id1 ) == nullptr );
+      BOOST_CHECK( db.find( id2 ) == nullptr );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( savepoint_remove_test )
+{
+   try {
+      database db;
+      auto ses = db._undo_db.start_undo_session();
+      const auto& bal_obj1 = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.balance = 1;
+      });
+      auto id1 = bal_obj1.id;
+      ses.commit();
+
+      // an object modified before a savepoint and removed after it is restored with its value before both
+      ses = db._undo_db.start_undo_session();
+      db.modify( id1(db), [&]( account_balance_object& obj ){ obj.balance = 2; } );
+      auto sp = db._undo_db.start_savepoint();
+      db.modify( id1(db), [&]( account_balance_object& obj ){ obj.balance = 3; } );
+      db.remove( id1(db) );
+      sp.commit();
+      ses.undo();
+      BOOST_CHECK( id1(db).balance == 1 );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( undo_image_test )
+{
+   try {
+      database db;
+      auto ses = db._undo_db.start_undo_session();
+      const auto& kept = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.balance = 1;
+      });
+      const auto& removed = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.balance = 2;
+      });
+      auto kept_id = kept.id;
+      auto removed_id = removed.id;
+      ses.commit();
+
+      ses = db._undo_db.start_undo_session();
+      db.modify( kept, [&]( account_balance_object& obj ){ obj.balance = 3; } );
+      db.remove( removed );
+      db.create<account_balance_object>( [&]( account_balance_object& obj ){ obj.balance = 4; } );
+      const auto image = db.pack_indexes( 1 );
+
+      // leaving out the newest undo state packs what undoing it restores
+      ses.undo();
+      BOOST_CHECK( kept_id(db).balance == 1 );
+      BOOST_CHECK( removed_id(db).balance == 2 );
+      const auto undone = db.pack_indexes( 0 );
+      BOOST_REQUIRE_EQUAL( image.size(), undone.size() );
+      for( size_t i = 0; i < image.size(); ++i )
+      {
+         BOOST_CHECK( image[i].first == undone[i].first );
+         BOOST_CHECK( image[i].second == undone[i].second );
+      }
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}